@@ -19,10 +19,12 @@ MESI_protocol::~MESI_protocol ()
 {
 }
 
+/** State names by state, NULL terminated, for dump () and the stats.  */
+const char *MESI_block_states[] = {"X","I","S","E","M", "IM", "IS", "IE", NULL};
+
 void MESI_protocol::dump (void)
 {
-    const char *block_states[8] = {"X","I","S","E","M", "IM", "IS", "IE"};
-    fprintf (stderr, "MESI_protocol - state: %s\n", block_states[state]);
+    sim_printf ("MESI_protocol - state: %s\n", MESI_block_states[state]);
 }
 
 void MESI_protocol::process_cache_request (Mreq *request)
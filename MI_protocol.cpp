@@ -19,13 +19,15 @@ MI_protocol::~MI_protocol ()
 {    
 }
 
+/* Printed by dump () and used by the stats.  It should be the same size and
+ * order as the state enum in the header, NULL terminated.
+ */
+const char *MI_block_states[] = {"X","I","IM","M", NULL};
+
 void MI_protocol::dump (void)
 {
-	/* This is used to dump the cache state as debug information.  The block_states
-	 * variable should be the same size and order as the state enum in the header.
-	 */
-    const char *block_states[4] = {"X","I","IM","M"};
-    fprintf (stderr, "MI_protocol - state: %s\n", block_states[state]);
+	/* This is used to dump the cache state as debug information.  */
+    sim_printf ("MI_protocol - state: %s\n", MI_block_states[state]);
 }
 
 void MI_protocol::process_cache_request (Mreq *request)
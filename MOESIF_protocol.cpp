@@ -17,10 +17,12 @@ MOESIF_protocol::~MOESIF_protocol ()
 {    
 }
 
+/** State names by state, NULL terminated, for dump () and the stats.  */
+const char *MOESIF_block_states[] = {"X","I","S","E","O","M","F", NULL};
+
 void MOESIF_protocol::dump (void)
 {
-    const char *block_states[9] = {"X","I","S","E","O","M","F"};
-    fprintf (stderr, "MOESIF_protocol - state: %s\n", block_states[state]);
+    sim_printf ("MOESIF_protocol - state: %s\n", MOESIF_block_states[state]);
 }
 
 void MOESIF_protocol::process_cache_request (Mreq *request)
@@ -19,10 +19,12 @@ MOESI_protocol::~MOESI_protocol ()
 {
 }
 
+/** State names by state, NULL terminated, for dump () and the stats.  */
+const char *MOESI_block_states[] = {"X","I","S","E","O","M", "IM", "ISE", "SM", "OM", NULL};
+
 void MOESI_protocol::dump (void)
 {
-    const char *block_states[10] = {"X","I","S","E","O","M", "IM", "ISE", "SM", "OM"};
-    fprintf (stderr, "MOESI_protocol - state: %s\n", block_states[state]);
+    sim_printf ("MOESI_protocol - state: %s\n", MOESI_block_states[state]);
 }
 
 void MOESI_protocol::process_cache_request (Mreq *request)
@@ -279,6 +281,10 @@ inline void MOESI_protocol::do_snoop_O (Mreq *request)
     case GETS:
       // (8.1.) Add your code here
       //Intervene with data
+      //assert shared so the requester ends in S, not E: its S copies may
+      //all have been evicted silently, and an E next to our O would let
+      //both of us answer the next GETM
+      set_shared_line();
       send_DATA_on_bus(request->addr, request->src_mid);
       break;
     case GETM:
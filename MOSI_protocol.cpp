@@ -19,10 +19,12 @@ MOSI_protocol::~MOSI_protocol ()
 {
 }
 
+/** State names by state, NULL terminated, for dump () and the stats.  */
+const char *MOSI_block_states[] = {"X","I","S","O","M", "IM", "IS", "SM", "OM", NULL};
+
 void MOSI_protocol::dump (void)
 {
-    const char *block_states[9] = {"X","I","S","O","M", "IM", "IS", "SM", "OM"};
-    fprintf (stderr, "MOSI_protocol - state: %s\n", block_states[state]);
+    sim_printf ("MOSI_protocol - state: %s\n", MOSI_block_states[state]);
 }
 
 void MOSI_protocol::process_cache_request (Mreq *request)
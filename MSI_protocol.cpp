@@ -19,10 +19,12 @@ MSI_protocol::~MSI_protocol ()
 {
 }
 
+/** State names by state, NULL terminated, for dump () and the stats.  */
+const char *MSI_block_states[] = {"X","I", "IM", "IS", "M","S", "SM", NULL};
+
 void MSI_protocol::dump (void)
 {
-    const char *block_states[7] = {"X","I", "IM", "IS", "M","S", "SM"};
-    fprintf (stderr, "MSI_protocol - state: %s\n", block_states[state]);
+    sim_printf ("MSI_protocol - state: %s\n", MSI_block_states[state]);
 }
 
 void MSI_protocol::process_cache_request (Mreq *request)
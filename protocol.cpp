@@ -43,7 +43,7 @@ void Protocol::send_DATA_on_bus(paddr_t addr, ModuleID dest)
 	// When DATA is sent on the bus it _MUST_ have a destination module
 	new_request = new Mreq(DATA, addr, my_table->moduleID, dest);
 	/* Debug Message -- DO NOT REMOVE or you won't match the validation runs */
-	fprintf(stderr,"**** DATA_SEND Cache: %d -- Clock: %lld\n",my_table->moduleID.nodeID,Global_Clock);
+	SIM_EVENT (LOG_VALIDATION, EV_DATA_SEND, my_table->moduleID, new_request);
 	/* This will but the message in the bus' arbitration queue to sent */
 	this->my_table->write_to_bus(new_request);
 
@@ -66,7 +66,7 @@ void Protocol::send_DATA_to_proc(paddr_t addr)
 void Protocol::set_shared_line ()
 {
 	// Set the bus' shared line
-	Sim->bus->shared_line = true;
+	Sim->bus->set_shared_active ();
 }
 
 bool Protocol::get_shared_line ()
@@ -1,12 +1,18 @@
 #include "bus.h"
 #include "mreq.h"
+#include "sim.h"
+
+extern Simulator *Sim;
 
 Bus::Bus()
 {
     current_request = NULL;
+    current_line = NULL;
     data_reply = NULL;
     request_in_progress = false;
     shared_line = false;
+    grant_time = 0;
+    transactions = 0;
 }
 
 Bus::~Bus()
@@ -18,6 +24,10 @@ void Bus::tick()
 	if (current_request)
 		delete current_request;
 
+	/** Every cache has seen last cycle's event by now.  */
+	if (Sim->ref_stream)
+		Sim->ref_stream->settle ();
+
 	if (request_in_progress)
 	{
 		if (data_reply)
@@ -25,6 +35,20 @@ void Bus::tick()
 			current_request = data_reply;
 			data_reply = NULL;
 			request_in_progress=false;
+			if (Sim->trace_export)
+				Sim->trace_export->bus_reply (current_request);
+			if (Sim->contention)
+				Sim->contention->bus_reply (current_request, Global_Clock - grant_time + 1);
+			if (Sim->sharing)
+				Sim->sharing->bus_reply (current_request, Global_Clock - grant_time + 1);
+			if (Sim->ref_stream)
+				Sim->ref_stream->bus_event (current_request);
+			if (Sim->stats)
+			{
+				/** Held from the grant through the reply.  */
+				Sim->stats->bus.busy_cycles += Global_Clock - grant_time + 1;
+				Sim->stats->bus.messages[DATA]++;
+			}
 		}
 		else
 		{
@@ -36,17 +60,54 @@ void Bus::tick()
 		shared_line = false;
 	    current_request = pending_requests.front();
 	    pending_requests.pop_front();
-	    request_in_progress = true;
+	    SIM_EVENT (LOG_DEBUG, EV_BUS_GRANT, current_request->src_mid, current_request);
+	    /** A writeback is done in one bus cycle, nobody replies.  */
+	    request_in_progress = (current_request->msg != DATA);
+	    grant_time = Global_Clock;
+	    transactions++;
+	    if (Sim->trace_export)
+	    	Sim->trace_export->bus_grant (current_request, pending_requests.size ());
+	    if (Sim->contention)
+	    	Sim->contention->bus_grant (current_request);
+	    if (Sim->sharing)
+	    	Sim->sharing->bus_grant (current_request);
+	    if (Sim->ref_stream)
+	    	Sim->ref_stream->bus_event (current_request);
+	    if (Sim->stats)
+	    {
+	    	Sim->stats->bus.messages[current_request->msg]++;
+	    	if (!request_in_progress)
+	    		Sim->stats->bus.busy_cycles++;
+	    }
 	}
 	else
 	{
 		current_request = NULL;
 	}
+
+	/** The current request has to be retired next cycle.  The line gets
+	 *  its record here, in the serial phase, the first time it is on the
+	 *  bus; its requester links to it when it snoops its own request.  */
+	current_line = NULL;
+	if (current_request)
+	{
+		if (Sim->lines)
+			current_line = Sim->lines->get (current_request->addr);
+		Sim->schedule (Global_Clock + 1);
+	}
 }
 
 bool Bus::bus_request(Mreq *request)
 {
-	if (request->msg == DATA)
+	/** Node workers queue their requests, they are replayed in node order.  */
+	if (sim_worker >= 0)
+	{
+		Sim->pool->defer_bus_request (sim_worker, request);
+		return true;
+	}
+
+	/** Writebacks to memory arbitrate like requests, other DATA is a reply.  */
+	if (request->msg == DATA && request->dest_mid.module_index != MC_M)
 	{
 		assert (data_reply == NULL);
 		data_reply = request;
@@ -54,23 +115,29 @@ bool Bus::bus_request(Mreq *request)
 	else
     {
         pending_requests.push_back(request);
+        if (Sim->stats && pending_requests.size () > Sim->stats->bus.queue_max)
+            Sim->stats->bus.queue_max = pending_requests.size ();
+        if (Sim->trace_export)
+            Sim->trace_export->bus_queue (pending_requests.size ());
     }
 
+	/** Arbitration happens on the next bus tick.  */
+	Sim->schedule (Global_Clock + 1);
+
 	return true;
 }
 
-Mreq* Bus::bus_snoop()
+void Bus::set_shared_active()
 {
-    Mreq *request;
+	if (sim_worker >= 0)
+		Sim->pool->defer_shared_line (sim_worker);
+	else
+		shared_line = true;
+}
 
-    if (current_request)
-    {
-        request = new Mreq ();
-        *request = *current_request;
-        return request;
-    }
-    else
-    {
-        return NULL;
-    }
+/** Every snooper gets the same message.  The bus owns it until the next
+ *  tick, snoopers must neither modify nor delete it.  */
+Mreq* Bus::bus_snoop()
+{
+    return current_request;
 }
@@ -3,6 +3,7 @@
 
 #include "types.h"
 
+class Line_entry;
 class Mreq;
 
 class Bus{
@@ -13,16 +14,23 @@ public:
     //TODO: Add shared, flush lines, etc...
 
 	Mreq *current_request;
+	/** Line table record of current_request, probed once per transaction.  */
+	Line_entry *current_line;
     LIST <Mreq *>pending_requests;
     Mreq *data_reply;
     
     bool request_in_progress;
+    /** Cycle the transaction in progress was granted.  */
+    timestamp_t grant_time;
+    /** Requests granted so far, writebacks included.  */
+    counter_t transactions;
 
     bool shared_line;
 
     void tick ();
 
     bool is_shared_active () { return shared_line; }
+    void set_shared_active ();
     bool bus_request (Mreq * request);
     Mreq *bus_snoop();
 };
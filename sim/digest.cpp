@@ -0,0 +1,216 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "digest.h"
+#include "sim.h"
+
+#define DIGEST_HEADER           "# event digest v1 interval %d\n"
+#define DIGEST_SEED             0xcbf29ce484222325ULL
+
+static inline uint64_t digest_mix (uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 32);
+}
+
+/***************************************************************************
+ * Event_digest constructor, destructor, and functions.
+ ***************************************************************************/
+Event_digest::Event_digest (const char *path, bool record, int interval,
+                            int line_size_log2, const char **msg_names)
+{
+    this->record = record;
+    this->interval = interval;
+    this->line_size_log2 = line_size_log2;
+    this->msg_names = msg_names;
+
+    file = fopen (path, record ? "w" : "r");
+    if (!file)
+        fatal_error ("Digest: Unable to open %s\n", path);
+
+    if (record)
+    {
+        fprintf (file, DIGEST_HEADER, interval);
+    }
+    else
+    {
+        digest_checkpoint_t cp;
+        unsigned long long events, first_clock, last_clock, hash;
+
+        /** The golden file decides the window size.  */
+        if (fscanf (file, DIGEST_HEADER, &this->interval) != 1 || this->interval <= 0)
+            fatal_error ("Digest: %s is not a digest file\n", path);
+
+        while (fscanf (file, "%llu %llu %llu %llx", &events, &first_clock, &last_clock, &hash) == 4)
+        {
+            cp.events = events;
+            cp.first_clock = first_clock;
+            cp.last_clock = last_clock;
+            cp.hash = hash;
+            for (int i = 0; i < DIGEST_SLICES; i++)
+            {
+                if (fscanf (file, "%llx", &hash) != 1)
+                    fatal_error ("Digest: %s is truncated\n", path);
+                cp.slice[i] = hash;
+            }
+            golden.push_back (cp);
+        }
+    }
+
+    window.reserve (this->interval);
+    reset ();
+    total_events = 0;
+    total_hash = DIGEST_SEED;
+    next_golden = 0;
+    diverged = false;
+}
+
+Event_digest::~Event_digest ()
+{
+    fclose (file);
+}
+
+void Event_digest::reset (void)
+{
+    memset (&current, 0, sizeof (current));
+    for (int i = 0; i < DIGEST_SLICES; i++)
+        current.slice[i] = DIGEST_SEED;
+}
+
+void Event_digest::add (const event_record_t *rec)
+{
+    const uint64_t *words = (const uint64_t *)rec;
+    uint64_t *slice = &current.slice[current.events * DIGEST_SLICES / interval];
+
+    if (current.events == 0)
+        current.first_clock = rec->clock;
+    current.last_clock = rec->clock;
+    current.events++;
+
+    for (unsigned int i = 0; i < sizeof (*rec) / sizeof (uint64_t); i++)
+        *slice = digest_mix (*slice, words[i]);
+
+    if (!record)
+        window.push_back (*rec);
+
+    if (current.events == (counter_t)interval)
+        checkpoint ();
+}
+
+void Event_digest::checkpoint (void)
+{
+    current.hash = DIGEST_SEED;
+    for (int i = 0; i < DIGEST_SLICES; i++)
+        current.hash = digest_mix (current.hash, current.slice[i]);
+
+    total_events += current.events;
+    total_hash = digest_mix (total_hash, current.hash);
+
+    if (record)
+    {
+        fprintf (file, "%llu %llu %llu %016llx", (unsigned long long)current.events,
+                 (unsigned long long)current.first_clock, (unsigned long long)current.last_clock,
+                 (unsigned long long)current.hash);
+        for (int i = 0; i < DIGEST_SLICES; i++)
+            fprintf (file, " %016llx", (unsigned long long)current.slice[i]);
+        fprintf (file, "\n");
+    }
+    else if (!diverged)
+    {
+        digest_checkpoint_t *expected = NULL;
+
+        if (next_golden < golden.size ())
+            expected = &golden[next_golden];
+        if (!expected || expected->events != current.events || expected->hash != current.hash)
+        {
+            diverged = true;
+            report (expected);
+        }
+        next_golden++;
+    }
+
+    window.clear ();
+    reset ();
+}
+
+/** Every earlier window matched, so the first difference is in this one,
+ *  and in its first slice that differs.  */
+void Event_digest::report (digest_checkpoint_t *expected)
+{
+    counter_t start = total_events - current.events;
+    char line[EVENT_LOG_MAX_LINE];
+    int slice = 0;
+    unsigned int first, last;
+
+    if (expected)
+        while (slice < DIGEST_SLICES - 1 && expected->slice[slice] == current.slice[slice])
+            slice++;
+
+    first = (slice * interval + DIGEST_SLICES - 1) / DIGEST_SLICES;
+    last = min ((unsigned int)window.size (),
+                (unsigned int)(((slice + 1) * interval + DIGEST_SLICES - 1) / DIGEST_SLICES));
+    /** The differing slice lies past the events this run recorded, or
+     *  there are none at all: there is no range to print.  */
+    if (first >= last)
+        first = last = window.size ();
+
+    if (first < last)
+        fprintf (stderr, "Digest mismatch in events %llu-%llu\n",
+                 (unsigned long long)(start + first), (unsigned long long)(start + last - 1));
+    else
+        fprintf (stderr, "Digest mismatch at event %llu, after the last one this run recorded\n",
+                 (unsigned long long)(start + first));
+    if (expected)
+        fprintf (stderr, "  golden window:   %llu events, cycles %llu-%llu\n",
+                 (unsigned long long)expected->events,
+                 (unsigned long long)expected->first_clock, (unsigned long long)expected->last_clock);
+    else
+        fprintf (stderr, "  golden window:   none, golden ends after event %llu\n",
+                 (unsigned long long)start);
+    fprintf (stderr, "  this run window: %llu events, cycles %llu-%llu\n",
+             (unsigned long long)current.events,
+             (unsigned long long)current.first_clock, (unsigned long long)current.last_clock);
+    if (first < last)
+        fprintf (stderr, "  first divergent cycle: %llu-%llu\n",
+                 (unsigned long long)window[first].clock, (unsigned long long)window[last - 1].clock);
+
+    fprintf (stderr, "  events of this run there:\n");
+    for (unsigned int i = first; i < last; i++)
+    {
+        event_render (&window[i], line_size_log2, msg_names[window[i].msg], line, sizeof (line));
+        fputs (line, stderr);
+    }
+}
+
+bool Event_digest::finish (void)
+{
+    if (current.events)
+        checkpoint ();
+
+    if (record)
+    {
+        fprintf (file, "total %llu %016llx\n", (unsigned long long)total_events,
+                 (unsigned long long)total_hash);
+        fflush (file);
+        fprintf (stderr, "Digest: recorded %llu events in %llu checkpoints\n",
+                 (unsigned long long)total_events,
+                 (unsigned long long)((total_events + interval - 1) / interval));
+        return true;
+    }
+
+    if (!diverged && next_golden < golden.size ())
+    {
+        digest_checkpoint_t *expected = &golden[next_golden];
+
+        diverged = true;
+        fprintf (stderr, "Digest mismatch: run ended after %llu events, golden continues\n",
+                 (unsigned long long)total_events);
+        fprintf (stderr, "  golden:   %llu more events from cycle %llu\n",
+                 (unsigned long long)expected->events, (unsigned long long)expected->first_clock);
+    }
+
+    if (!diverged)
+        fprintf (stderr, "Digest: match, %llu events\n", (unsigned long long)total_events);
+    return !diverged;
+}
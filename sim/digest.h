@@ -0,0 +1,61 @@
+#ifndef DIGEST_H_
+#define DIGEST_H_
+
+#include "event_log.h"
+#include "types.h"
+
+/** Events hashed per checkpoint.  */
+#define DIGEST_INTERVAL         1024
+
+/** Each checkpoint also hashes its window in this many slices, so a
+ *  mismatch is narrowed down to interval / DIGEST_SLICES events.  */
+#define DIGEST_SLICES           16
+
+typedef struct {
+    counter_t events;
+    timestamp_t first_clock;
+    timestamp_t last_clock;
+    uint64_t hash;
+    uint64_t slice[DIGEST_SLICES];
+} digest_checkpoint_t;
+
+/**
+ * Rolling hash of the event stream, checkpointed every interval events.
+ * In record mode the checkpoints are written to a small text file; in check
+ * mode they are compared against one, and the first window that differs is
+ * narrowed to the first slice that differs, whose cycles and events are
+ * reported instead of writing the full log.
+ */
+class Event_digest {
+public:
+    Event_digest (const char *path, bool record, int interval,
+                  int line_size_log2, const char **msg_names);
+    ~Event_digest ();
+
+    void add (const event_record_t *rec);
+
+    /** Closes the last window and reports, false on a mismatch.  */
+    bool finish (void);
+
+private:
+    FILE *file;
+    bool record;
+    int interval;
+    int line_size_log2;
+    const char **msg_names;
+
+    digest_checkpoint_t current;
+    VECTOR<event_record_t> window;
+    counter_t total_events;
+    uint64_t total_hash;
+
+    VECTOR<digest_checkpoint_t> golden;
+    unsigned int next_golden;
+    bool diverged;
+
+    void reset (void);
+    void checkpoint (void);
+    void report (digest_checkpoint_t *expected);
+};
+
+#endif /*DIGEST_H_*/
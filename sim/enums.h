@@ -24,6 +24,14 @@ typedef enum {
     MEM_PRO
 } protocol_t;
 
+/** Simulator event log verbosity.  LOG_VALIDATION is the per-event trace
+ *  the reference outputs are checked against.  */
+typedef enum {
+    LOG_QUIET = 0,
+    LOG_VALIDATION,
+    LOG_DEBUG
+} log_level_t;
+
 typedef enum {
     TIER0 = 0,
     TIER1,
@@ -77,7 +85,8 @@ typedef enum {
 	OUTPUT_FMT_COUT = 0,
 	OUTPUT_FMT_CERR,
 	OUTPUT_FMT_CSV,
-	OUTPUT_FMT_NONE
+	OUTPUT_FMT_NONE,
+	OUTPUT_FMT_JSON
 } sim_output_mode_t;
 
 typedef enum {
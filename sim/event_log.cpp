@@ -0,0 +1,126 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "event_log.h"
+
+const char *event_kind_str[EV_NUM_KINDS] = {
+    "FETCH", "COMPLETE", "PROC_REQUEST", "SNOOP_REQUEST",
+    "BUS_GRANT", "WRITEBACK", "DATA_SEND", "MC_DATA_SEND"
+};
+
+/** Same layout as print_id ().  */
+static int render_id (char *buf, size_t size, const char *str, int node, int module)
+{
+    static const char *module_str[] = {"NI", "PR", "L1", "L2", "L3", "MC"};
+
+    if (module >= 6)
+        return snprintf (buf, size, "%4s:  None ", str);
+    return snprintf (buf, size, "%4s:%3d/%s  ", str, node, module_str[module]);
+}
+
+int event_render (const event_record_t *rec, int line_size_log2,
+                  const char *msg_name, char *buf, size_t size)
+{
+    const char *prefix;
+    int len;
+
+    switch (rec->kind) {
+    case EV_FETCH:
+        return snprintf (buf, size, "* FETCH -- PR: %d -- Clock: %lld -- %c 0x%llx\n",
+                         rec->node, (long long)rec->clock, rec->op, (unsigned long long)rec->addr);
+    case EV_COMPLETE:
+        return snprintf (buf, size, "* COMPLETE -- PR: %d -- Clock: %lld\n",
+                         rec->node, (long long)rec->clock);
+    case EV_WRITEBACK:
+        return snprintf (buf, size, "**** WRITEBACK Cache: %d -- Clock: %lld\n",
+                         rec->node, (long long)rec->clock);
+    case EV_DATA_SEND:
+        return snprintf (buf, size, "**** DATA_SEND Cache: %d -- Clock: %lld\n",
+                         rec->node, (long long)rec->clock);
+    case EV_MC_DATA_SEND:
+        return snprintf (buf, size, "**** DATA SEND MC -- Clock: %lld\n",
+                         (long long)rec->clock);
+    case EV_PROC_REQUEST:  prefix = "** PROC REQUEST -- "; break;
+    case EV_SNOOP_REQUEST: prefix = "*** SNOOP REQUEST -- "; break;
+    case EV_BUS_GRANT:     prefix = "***** BUS GRANT -- "; break;
+    default:
+        return snprintf (buf, size, "**** UNKNOWN EVENT %d\n", rec->kind);
+    }
+
+    /** Same layout as Mreq::print_msg ().  */
+    len = snprintf (buf, size, "%s", prefix);
+    len += render_id (buf + len, size - len, "node", rec->node, rec->module);
+    len += render_id (buf + len, size - len, "src", rec->src_node, rec->src_module);
+    len += render_id (buf + len, size - len, "dest", rec->dest_node, rec->dest_module);
+    len += snprintf (buf + len, size - len, "tag: 0x%8llx clock: %8lld ",
+                     (long long int)rec->addr >> line_size_log2, (long long)rec->clock);
+    len += snprintf (buf + len, size - len, " %8s\n", msg_name);
+    return len;
+}
+
+/***************************************************************************
+ * Event_log constructor, destructor, and functions.
+ ***************************************************************************/
+Event_log::Event_log ()
+{
+    header = NULL;
+    records = NULL;
+    map_size = 0;
+}
+
+Event_log::~Event_log ()
+{
+    if (header)
+        munmap (header, map_size);
+}
+
+bool Event_log::open (const char *path, uint64_t capacity, int line_size_log2,
+                      const char **msg_names, int num_msgs)
+{
+    int fd;
+    void *map;
+
+    if (capacity == 0 || num_msgs > EVENT_LOG_MAX_MSGS)
+        return false;
+
+    fd = ::open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    map_size = EVENT_LOG_DATA_OFFSET + capacity * sizeof (event_record_t);
+    if (ftruncate (fd, map_size) < 0)
+    {
+        close (fd);
+        return false;
+    }
+
+    map = mmap (NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    header = (event_log_header_t *)map;
+    records = (event_record_t *)((char *)map + EVENT_LOG_DATA_OFFSET);
+
+    memset (header, 0, sizeof (*header));
+    header->magic = EVENT_LOG_MAGIC;
+    header->version = EVENT_LOG_VERSION;
+    header->record_size = sizeof (event_record_t);
+    header->line_size_log2 = line_size_log2;
+    header->capacity = capacity;
+    header->count = 0;
+    header->num_msgs = num_msgs;
+    for (int i = 0; i < num_msgs; i++)
+        strncpy (header->msg_names[i], msg_names[i], EVENT_LOG_NAME_LEN - 1);
+
+    return true;
+}
+
+void Event_log::append (const event_record_t *rec)
+{
+    records[header->count % header->capacity] = *rec;
+    header->count++;
+}
@@ -0,0 +1,85 @@
+#ifndef EVENT_LOG_H_
+#define EVENT_LOG_H_
+
+#include "types.h"
+
+/**
+ * Binary simulator event log.  A header page, then a ring of fixed size
+ * records in an mmap'd file.  Once the ring is full the oldest records are
+ * overwritten; count tells a reader where the ring starts.  The header
+ * carries the message names so the file decodes without the protocols.
+ */
+#define EVENT_LOG_MAGIC         0x474c5645      /** "EVLG" */
+#define EVENT_LOG_VERSION       1
+#define EVENT_LOG_DATA_OFFSET   4096
+#define EVENT_LOG_MAX_MSGS      32
+#define EVENT_LOG_NAME_LEN      16
+
+/** Longest rendered event line.  */
+#define EVENT_LOG_MAX_LINE      256
+
+typedef enum {
+    EV_FETCH = 0,
+    EV_COMPLETE,
+    EV_PROC_REQUEST,
+    EV_SNOOP_REQUEST,
+    EV_BUS_GRANT,
+    EV_WRITEBACK,
+    EV_DATA_SEND,
+    EV_MC_DATA_SEND,
+    EV_NUM_KINDS
+} event_kind_t;
+
+extern const char *event_kind_str[EV_NUM_KINDS];
+
+/** Node and module ids follow ModuleID, node -1 is "None".  */
+typedef struct {
+    uint64_t clock;
+    uint64_t addr;
+    int16_t node;
+    int16_t src_node;
+    int16_t dest_node;
+    uint8_t kind;
+    uint8_t module;
+    uint8_t src_module;
+    uint8_t dest_module;
+    uint8_t msg;
+    char op;
+    uint8_t pad[4];
+} event_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t line_size_log2;
+    uint64_t capacity;
+    uint64_t count;
+    uint32_t num_msgs;
+    uint32_t pad;
+    char msg_names[EVENT_LOG_MAX_MSGS][EVENT_LOG_NAME_LEN];
+} event_log_header_t;
+
+/** Formats rec exactly as the text log prints it, returns the length.  */
+int event_render (const event_record_t *rec, int line_size_log2,
+                  const char *msg_name, char *buf, size_t size);
+
+/** Writer side, owns the mapping.  Also linked into simlog, so failures
+ *  are returned rather than reported.  */
+class Event_log {
+public:
+    Event_log ();
+    ~Event_log ();
+
+    bool open (const char *path, uint64_t capacity, int line_size_log2,
+               const char **msg_names, int num_msgs);
+
+    void append (const event_record_t *rec);
+
+private:
+    event_log_header_t *header;
+    event_record_t *records;
+    size_t map_size;
+};
+
+#endif /*EVENT_LOG_H_*/
@@ -0,0 +1,86 @@
+#include <assert.h>
+
+#include "event_wheel.h"
+#include "settings.h"
+#include "sim.h"
+
+/***************************************************************************
+ * Event_wheel constructor, destructor, and functions.
+ ***************************************************************************/
+Event_wheel::Event_wheel (int slots)
+{
+    if (slots <= 0 || !ISPOW2 (slots))
+        fatal_error ("Event_wheel: Invalid number of slots - %d\n", slots);
+
+    this->num_slots = slots;
+    this->slot_mask = slots - 1;
+    this->pending = 0;
+    this->now = 0;
+
+    wheel.assign (slots, false);
+    overflow.clear ();
+}
+
+Event_wheel::~Event_wheel ()
+{
+}
+
+/** Wheel slots only ever hold wakeups in [now, now + num_slots), so every
+ *  slot maps to exactly one cycle.  Anything further out waits in overflow.  */
+void Event_wheel::schedule (timestamp_t when)
+{
+    assert (when >= now && "Event_wheel: wakeup scheduled in the past");
+
+    if (when - now >= (timestamp_t)num_slots)
+    {
+        overflow.insert (when);
+        return;
+    }
+
+    if (!wheel[when & slot_mask])
+    {
+        wheel[when & slot_mask] = true;
+        pending++;
+    }
+}
+
+void Event_wheel::migrate_overflow (void)
+{
+    while (!overflow.empty () && *overflow.begin () - now < (timestamp_t)num_slots)
+    {
+        timestamp_t when = *overflow.begin ();
+        overflow.erase (overflow.begin ());
+        schedule (when);
+    }
+}
+
+/** Pop the earliest pending wakeup.  Returns false when nothing is scheduled.  */
+bool Event_wheel::next_event (timestamp_t *when)
+{
+    if (pending == 0)
+    {
+        if (overflow.empty ())
+            return false;
+
+        now = *overflow.begin ();
+    }
+    migrate_overflow ();
+
+    for (timestamp_t t = now; ; t++)
+    {
+        if (wheel[t & slot_mask])
+        {
+            wheel[t & slot_mask] = false;
+            pending--;
+            now = t;
+            migrate_overflow ();
+            *when = t;
+            return true;
+        }
+    }
+}
+
+bool Event_wheel::empty (void)
+{
+    return (pending == 0 && overflow.empty ());
+}
@@ -0,0 +1,37 @@
+#ifndef EVENT_WHEEL_H_
+#define EVENT_WHEEL_H_
+
+#include "types.h"
+
+/** Number of cycles covered by the wheel; wakeups further out go to overflow.  */
+#define EVENT_WHEEL_SLOTS       256
+
+/**
+ * Timing wheel of pending simulator wakeups.  Modules schedule the cycle at
+ * which they next have work and the run loop jumps global_clock straight to
+ * the earliest one.  Several wakeups for the same cycle collapse into one.
+ */
+class Event_wheel {
+public:
+    Event_wheel (int slots);
+    ~Event_wheel ();
+
+    /** Cycle of the most recently popped wakeup.  */
+    timestamp_t now;
+
+    void schedule (timestamp_t when);
+    bool next_event (timestamp_t *when);
+    bool empty (void);
+
+private:
+    int num_slots;
+    int slot_mask;
+    int pending;
+
+    VECTOR<bool> wheel;
+    SET<timestamp_t> overflow;
+
+    void migrate_overflow (void);
+};
+
+#endif /* EVENT_WHEEL_H_ */
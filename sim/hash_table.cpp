@@ -18,69 +18,15 @@
 
 using namespace std;
 
+extern Sim_settings settings;
 extern Simulator *Sim;
 
-/***************************************************************************
- * Hash_entry constructor, destructor, and functions.
- ***************************************************************************/
-Hash_entry::Hash_entry (Hash_table *t, paddr_t tag)
-{
-    this->my_table = t;
-    this->tag = tag;
-
-    switch (my_table->protocol) {
-    case MI_PRO:
-        protocol = new MI_protocol (my_table, this);
-        break;
-    case MSI_PRO:
-    	protocol = new MSI_protocol (my_table, this);
-    	break;
-    case MESI_PRO:
-    	protocol = new MESI_protocol (my_table, this);
-    	break;
-    case MOSI_PRO:
-    	protocol = new MOSI_protocol (my_table, this);
-    	break;
-    case MOESI_PRO:
-    	protocol = new MOESI_protocol (my_table, this);
-    	break;
-    case MOESIF_PRO:
-    	protocol = new MOESIF_protocol (my_table, this);
-    	break;
-    default:
-        fatal_error ("Hash_entry: Unknown coherence protocol!\n");
-    }
-}
-
-Hash_entry::~Hash_entry (void)
-{
-}
-
-void Hash_entry::process_request_snoop (Mreq *request)
-{
-    assert (protocol);
-    assert (request);
-
-    protocol->process_snoop_request (request);
-}
-
-void Hash_entry::process_request_processor (Mreq *request)
-{
-    protocol->process_cache_request (request);
-}
-
-void Hash_entry::dump (void)
-{
-    fprintf (stderr, "Addr: 0x%llx ", (unsigned long long)tag);
-    protocol->dump ();
-}
-
 /***************************************************************************
  * Hash constructor, destructor, and fucntions.
  ***************************************************************************/
 Hash_table::Hash_table (ModuleID moduleID, const char *name,
                         int size, int assoc, int blocksize, int mshrs,
-                        int hit_time, protocol_t protocol)
+                        int hit_time, protocol_t protocol, bool infinite)
 	: Module (moduleID, name)
 {
     /** Sanity check.  */
@@ -102,7 +48,7 @@ Hash_table::Hash_table (ModuleID moduleID, const char *name,
     this->mshrs = mshrs;
     this->hit_time = hit_time;
     this->protocol = protocol;
-
+    this->infinite = infinite;
 
     /** Calculate tag and index masks once.  */
     num_index_bits = (int) log2 (sets);
@@ -118,7 +64,10 @@ Hash_table::Hash_table (ModuleID moduleID, const char *name,
     index_mask = index_mask << (num_offset_bits);
     index_mask = index_mask & ~tag_mask;
 
-    my_entries.clear ();
+    proc_request = NULL;
+    active_entry = NULL;
+    allocated = false;
+    miss_type = MISS_COLD;
 }
 
 /** Destructor.  */
@@ -127,10 +76,47 @@ Hash_table::~Hash_table (void)
 
 }
 
+template <class P>
+Protocol_hash_table<P>::Protocol_hash_table (ModuleID moduleID, const char *name,
+                                             int size, int assoc, int blocksize, int mshrs,
+                                             int hit_time, protocol_t protocol, bool infinite)
+    : Hash_table (moduleID, name, size, assoc, blocksize, mshrs, hit_time, protocol, infinite),
+      machine (this, NULL)
+{
+    initial_state = machine.state;
+    slab_size = 0;
+    slab_used = 0;
+
+    ways = NULL;
+    last_use = NULL;
+    lru_clock = 0;
+    evicted = NULL;
+    evicted_shift = 0;
+    if (!infinite)
+    {
+        ways = new Hash_entry[sets * assoc];
+        last_use = new counter_t[sets * assoc]();
+        for (int i = 0; i < sets * assoc; i++)
+            init_entry (&ways[i], LINE_MAP_EMPTY);
+    }
+}
+
+template <class P>
+Protocol_hash_table<P>::~Protocol_hash_table (void)
+{
+    for (unsigned int i = 0; i < slabs.size (); i++)
+        delete [] slabs[i];
+
+    delete [] ways;
+    delete [] last_use;
+    delete [] evicted;
+}
+
 /*****************************
  * Hash tick/tock functions.
  *****************************/
-void Hash_table::tick (void)
+template <class P>
+void Protocol_hash_table<P>::tick (void)
 {
     Mreq *request;
     Hash_entry *entry;
@@ -138,12 +124,15 @@ void Hash_table::tick (void)
     /** Request from processor.  */
     if (proc_request)
     {
-    	fprintf(stderr,"** PROC REQUEST -- ");
-    	proc_request->print_msg (moduleID, NULL);
+    	SIM_EVENT (LOG_VALIDATION, EV_PROC_REQUEST, moduleID, proc_request);
     	Sim->cache_accesses++;
+        allocated = false;
         entry = get_entry (proc_request->addr);
         assert (entry);
-        entry->process_request_processor (proc_request);
+        if (Sim->stats)
+            count_access (entry, proc_request);
+        process_cache_request (entry, proc_request);
+        publish_state (entry);
         delete proc_request;
         proc_request = NULL;
     }
@@ -157,14 +146,95 @@ void Hash_table::tick (void)
     		return;
     	}
 
-    	fprintf(stderr,"*** SNOOP REQUEST -- ");
-        request->print_msg (moduleID, NULL);
-        entry = get_entry (request->addr);
-        assert (entry);
-        entry->process_request_snoop (request);
+    	/** Our miss is served, note by whom for the latency stats.  */
+    	if (Sim->stats && request->msg == DATA)
+    	{
+    		Processor *pr = Sim->get_PR (moduleID.nodeID);
+    		if (pr->preq)
+    			pr->preq->source = request->src_mid.module_index;
+    	}
+
+    	SIM_EVENT (LOG_VALIDATION, EV_SNOOP_REQUEST, moduleID, request);
+    	if (Sim->stats && request->src_mid != moduleID)
+    		Sim->stats->core (moduleID.nodeID)->snooped[request->msg]++;
+
+        /** Snoops never allocate, a missing line is in I, and a snoop in I
+         *  does nothing in any protocol.  Infinite tables read their state
+         *  from the bus' line record and only look the line up when there
+         *  is something to do.  A line's first request is what creates its
+         *  record, so the requester links it on seeing the request; until
+         *  then it is in a transient state from I, and those ignore other
+         *  caches' GETS and GETM in every protocol.  */
+        if (infinite)
+        {
+            Line_entry *line = Sim->bus->current_line;
+            int state;
+
+            if (request->msg != DATA && request->src_mid == moduleID)
+            {
+                entry = find_entry (request->addr);
+                assert (entry);
+                if (!entry->record)
+                {
+                    entry->record = line;
+                    publish_state (entry);
+                }
+            }
+            else
+            {
+                state = line->get_state (moduleID.nodeID);
+                entry = (state >= 0 && state_valid (state)) ? find_entry (request->addr) : NULL;
+            }
+        }
+        else
+        {
+            entry = find_entry (request->addr);
+
+            /** Our own request, the line stayed put while it waited.  */
+            if (request->msg != DATA && request->src_mid == moduleID)
+            {
+                assert (entry && entry->bus_pending);
+                entry->bus_pending--;
+            }
+        }
+
+        if (entry)
+        {
+            process_snoop_request (entry, request);
+            publish_state (entry);
+        }
     }
 }
 
+/** Stats for a processor access, before the protocol sees it.  */
+template <class P>
+void Protocol_hash_table<P>::count_access (Hash_entry *entry, Mreq *request)
+{
+    core_stats_t *core = Sim->stats->core (moduleID.nodeID);
+    paddr_t *slot;
+
+    if (request->msg == LOAD)
+        core->loads++;
+    else
+        core->stores++;
+
+    assert (entry->state < STATS_MAX_STATES);
+    core->access_state[entry->state]++;
+
+    /** Only counted if the access goes to the bus, see write_to_bus.  */
+    if (state_valid (entry->state))
+        miss_type = MISS_UPGRADE;
+    else if (!allocated)
+        miss_type = MISS_COHERENCE;
+    else if (evicted && (*(slot = evicted_slot (entry->tag)) & ~(paddr_t)1) == entry->tag)
+    {
+        miss_type = (*slot & 1) ? MISS_CAPACITY : MISS_COHERENCE;
+        *slot = LINE_MAP_EMPTY;
+    }
+    else
+        miss_type = MISS_COLD;
+}
+
 /** Request sent from processor.  */
 void Hash_table::processor_request (Mreq *request)
 {
@@ -180,16 +250,125 @@ void Hash_table::tock (void)
 /*******************************
  * Generic Hash_table functions.
  *******************************/
-Hash_entry* Hash_table::get_entry (paddr_t addr)
+template <class P>
+Hash_entry* Protocol_hash_table<P>::get_infinite_entry (paddr_t addr)
+{
+    Hash_entry **found;
+    Hash_entry *entry;
+
+    found = my_entries.find (addr);
+    if (found)
+        return *found;
+
+    if (slab_used == slab_size)
+    {
+        slab_size = slabs.empty () ? HASH_SLAB_MIN : min (slab_size * 2, HASH_SLAB_MAX);
+        slabs.push_back (new Hash_entry[slab_size]);
+        slab_used = 0;
+    }
+    entry = &slabs.back ()[slab_used++];
+    init_entry (entry, addr);
+
+    my_entries.insert (addr, entry);
+    allocated = true;
+    return entry;
+}
+
+/** Lookup only, returns NULL when the line is not in the table.  */
+template <class P>
+Hash_entry* Protocol_hash_table<P>::find_entry (paddr_t addr)
+{
+    if (infinite)
+    {
+        Hash_entry **found = my_entries.find (addr);
+
+        return found ? *found : NULL;
+    }
+
+    Hash_entry *set = &ways[get_set (addr) * assoc];
+    for (int i = 0; i < assoc; i++)
+        if (set[i].tag == addr)
+            return &set[i];
+    return NULL;
+}
+
+/** Processor access: hit, or allocate the line evicting the LRU way.  */
+template <class P>
+Hash_entry* Protocol_hash_table<P>::get_entry (paddr_t addr)
 {
-    MAP<paddr_t, Hash_entry*>::iterator it;
-    
-    it = my_entries.find (addr);
-    if (it == my_entries.end ())
+    int base;
+
+    if (infinite)
+        return get_infinite_entry (addr);
+
+    base = get_set (addr) * assoc;
+    for (int i = base; i < base + assoc; i++)
+        if (ways[i].tag == addr)
+        {
+            last_use[i] = ++lru_clock;
+            return &ways[i];
+        }
+
+    return replace_entry (addr);
+}
+
+/** Pick an empty way, else an invalid one, else the least recently used
+ *  line.  Dirty victims are written back to memory over the bus.  */
+template <class P>
+Hash_entry* Protocol_hash_table<P>::replace_entry (paddr_t addr)
+{
+    Hash_entry *way;
+    int base, victim;
+
+    base = get_set (addr) * assoc;
+    victim = -1;
+    for (int i = base; i < base + assoc; i++)
     {
-        my_entries.insert(pair<paddr_t, Hash_entry*>(addr,new Hash_entry (this, addr)));       
+        if (ways[i].bus_pending)
+            continue;
+        if (ways[i].tag == LINE_MAP_EMPTY || !state_valid (ways[i].state))
+        {
+            victim = i;
+            break;
+        }
+        if (victim == -1 || last_use[i] < last_use[victim])
+            victim = i;
     }
-    return my_entries[addr];
+    if (victim == -1)
+        fatal_error ("%s %d: every way of set %d has a bus request pending\n",
+                     name, moduleID.nodeID, get_set (addr));
+
+    way = &ways[victim];
+    if (way->tag != LINE_MAP_EMPTY)
+    {
+        if (state_valid (way->state) && state_dirty (way->state))
+            write_back (way->tag);
+        if (Sim->stats)
+        {
+            if (!evicted)
+                alloc_evicted ();
+            *evicted_slot (way->tag) = way->tag | (state_valid (way->state) ? 1 : 0);
+        }
+    }
+
+    init_entry (way, addr);
+    allocated = true;
+    last_use[victim] = ++lru_clock;
+    return way;
+}
+
+/** Sized on the first eviction, tables that never evict need none.  */
+template <class P>
+void Protocol_hash_table<P>::alloc_evicted (void)
+{
+    int slots = 1;
+
+    while (slots < HASH_EVICTED_RATIO * sets * assoc)
+        slots *= 2;
+    evicted_shift = 64 - __builtin_ctzll (slots);
+    evicted = new paddr_t[slots];
+    for (int i = 0; i < slots; i++)
+        evicted[i] = LINE_MAP_EMPTY;
 }
 
 bool Hash_table::write_to_proc (Mreq *mreq)
@@ -207,37 +386,184 @@ bool Hash_table::write_to_proc (Mreq *mreq)
 bool Hash_table::write_to_bus (Mreq *mreq)
 {
 	mreq->src_mid = moduleID;
+	if (!infinite && mreq->msg != DATA)
+	{
+		assert (active_entry && active_entry->tag == mreq->addr);
+		active_entry->bus_pending++;
+	}
+
+	if (Sim->stats)
+	{
+		core_stats_t *core = Sim->stats->core (moduleID.nodeID);
+
+		core->bus_sent[mreq->msg]++;
+		if (mreq->msg != DATA)
+		{
+			Processor *pr = Sim->get_PR (moduleID.nodeID);
+
+			core->misses[miss_type]++;
+			if (pr->preq && miss_type == MISS_UPGRADE)
+				pr->preq->upgrade = true;
+		}
+		else if (mreq->dest_mid.module_index == MC_M)
+			core->writebacks++;
+		else
+			core->cache_to_cache++;
+	}
 	return this->write_output_port(mreq);
 }
 
+/** Evicted dirty line goes back to the memory controller as DATA.  */
+void Hash_table::write_back (paddr_t addr)
+{
+	Mreq * new_request;
+	new_request = new Mreq(DATA, addr, moduleID, (ModuleID){settings.num_nodes, MC_M});
+	SIM_EVENT (LOG_VALIDATION, EV_WRITEBACK, moduleID, NULL, 0, addr);
+	this->write_to_bus(new_request);
+
+	Sim->writebacks++;
+}
+
 /********
  * Debug.
  ********/
-void Hash_table::dump_hash_entry (paddr_t addr)
+template <class P>
+void Protocol_hash_table<P>::dump_entry (paddr_t tag, uint8_t state)
+{
+    sim_printf ("Addr: 0x%llx ", (unsigned long long)tag);
+    load_state (&machine.state, state);
+    machine.P::dump ();
+}
+
+template <class P>
+void Protocol_hash_table<P>::dump_hash_entry (paddr_t addr)
 {
     Hash_entry *entry;
 
-    entry = get_entry (addr);
+    entry = find_entry (addr);
     if (entry)
-        entry->dump ();
+        dump_entry (entry->tag, entry->state);
 }
 
-void Hash_table::dump_hash_table ()
+template <class P>
+void Protocol_hash_table<P>::dump_hash_table ()
 {
-	MAP<paddr_t, Hash_entry*>::iterator it;
+	sim_printf("Cache %d Contents:\n",moduleID.nodeID);
 
-	fprintf(stderr, "Cache %d Contents:\n",moduleID.nodeID);
+	/** Lines this cache never touched are listed in their initial (I) state.  */
+	if (infinite)
+	{
+		VECTOR<paddr_t> addrs;
+
+		Sim->lines->get_lines (&addrs);
+		for (unsigned int i = 0; i < addrs.size (); i++)
+		{
+			Hash_entry **found = my_entries.find (addrs[i]);
+			if (found)
+				dump_entry ((*found)->tag, (*found)->state);
+			else
+				dump_entry (addrs[i], initial_state);
+		}
+	}
 
-	for (it = my_entries.begin(); it != my_entries.end(); it++)
+	/** Resident lines in address order too, not way order, so dumps do
+	 *  not depend on the L1 geometry.  */
+	if (ways)
 	{
-		it->second->dump();
+		VECTOR<pair<paddr_t, int> > resident;
+
+		for (int i = 0; i < sets * assoc; i++)
+		{
+			if (ways[i].tag != LINE_MAP_EMPTY)
+				resident.push_back (make_pair (ways[i].tag, i));
+		}
+		sort (resident.begin (), resident.end ());
+		for (unsigned int i = 0; i < resident.size (); i++)
+			dump_entry (resident[i].first, ways[resident[i].second].state);
 	}
 
 }
 
+/** Lines held at the end of the run, by state.  */
+template <class P>
+void Protocol_hash_table<P>::count_states (counter_t *states)
+{
+	for (size_t i = 0; i < my_entries.num_slots (); i++)
+	{
+		Line_map<Hash_entry*>::slot_t *slot = my_entries.slot (i);
+
+		if (slot->tag != LINE_MAP_EMPTY)
+			states[slot->value->state]++;
+	}
+
+	for (int i = 0; ways && i < sets * assoc; i++)
+	{
+		if (ways[i].tag != LINE_MAP_EMPTY)
+			states[ways[i].state]++;
+	}
+}
+
+template <class P>
+int Protocol_hash_table<P>::line_state (paddr_t addr)
+{
+	Hash_entry *entry = find_entry (addr);
+
+	return entry ? (int)entry->state : -1;
+}
+
 void Hash_table::print_config (void)
 {
     fprintf (stderr, "%s CONFIGURATION\n", name);
     fprintf (stderr, " blocksize:         %d bytes\n", blocksize);
 }
 
+/** Valid lines occupy a way, dirty ones must be written back on eviction.  */
+template <> bool Protocol_hash_table<MI_protocol>::state_valid (int state) { return state != MI_CACHE_I; }
+template <> bool Protocol_hash_table<MI_protocol>::state_dirty (int state) { return state == MI_CACHE_M; }
+
+template <> bool Protocol_hash_table<MSI_protocol>::state_valid (int state) { return state != MSI_CACHE_I; }
+template <> bool Protocol_hash_table<MSI_protocol>::state_dirty (int state) { return state == MSI_CACHE_M; }
+
+template <> bool Protocol_hash_table<MESI_protocol>::state_valid (int state) { return state != MESI_CACHE_I; }
+template <> bool Protocol_hash_table<MESI_protocol>::state_dirty (int state) { return state == MESI_CACHE_M; }
+
+template <> bool Protocol_hash_table<MOSI_protocol>::state_valid (int state) { return state != MOSI_CACHE_I; }
+template <> bool Protocol_hash_table<MOSI_protocol>::state_dirty (int state)
+{
+    return state == MOSI_CACHE_M || state == MOSI_CACHE_O;
+}
+
+template <> bool Protocol_hash_table<MOESI_protocol>::state_valid (int state) { return state != MOESI_CACHE_I; }
+template <> bool Protocol_hash_table<MOESI_protocol>::state_dirty (int state)
+{
+    return state == MOESI_CACHE_M || state == MOESI_CACHE_O;
+}
+
+template <> bool Protocol_hash_table<MOESIF_protocol>::state_valid (int state) { return state != MOESIF_CACHE_I; }
+template <> bool Protocol_hash_table<MOESIF_protocol>::state_dirty (int state)
+{
+    return state == MOESIF_CACHE_M || state == MOESIF_CACHE_O;
+}
+
+/** The protocols' own tables, the names their dump () prints.  */
+extern const char *MI_block_states[];
+extern const char *MSI_block_states[];
+extern const char *MESI_block_states[];
+extern const char *MOSI_block_states[];
+extern const char *MOESI_block_states[];
+extern const char *MOESIF_block_states[];
+
+template <> const char **Protocol_hash_table<MI_protocol>::state_names (void) { return MI_block_states; }
+template <> const char **Protocol_hash_table<MSI_protocol>::state_names (void) { return MSI_block_states; }
+template <> const char **Protocol_hash_table<MESI_protocol>::state_names (void) { return MESI_block_states; }
+template <> const char **Protocol_hash_table<MOSI_protocol>::state_names (void) { return MOSI_block_states; }
+template <> const char **Protocol_hash_table<MOESI_protocol>::state_names (void) { return MOESI_block_states; }
+template <> const char **Protocol_hash_table<MOESIF_protocol>::state_names (void) { return MOESIF_block_states; }
+
+/** One table per protocol, selected in Node::build_processor.  */
+template class Protocol_hash_table<MI_protocol>;
+template class Protocol_hash_table<MSI_protocol>;
+template class Protocol_hash_table<MESI_protocol>;
+template class Protocol_hash_table<MOSI_protocol>;
+template class Protocol_hash_table<MOESI_protocol>;
+template class Protocol_hash_table<MOESIF_protocol>;
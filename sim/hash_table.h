@@ -3,32 +3,45 @@
 
 #include <iostream>
 
+#include "line_map.h"
+#include "line_table.h"
 #include "module.h"
 #include "mreq.h"
 #include "settings.h"
+#include "stats.h"
 #include "types.h"
 #include "../protocols/protocol.h"
 
 using namespace std;
 
-/** Individual entry for a hardware hash-like structure. */
+/**
+ * Individual entry for a hardware hash-like structure.  The line's
+ * coherence state is stored inline as the protocol's state enum, in one
+ * byte, and the table runs the protocol's transitions on it, so a line is
+ * its tag, its state and its Line_table record and nothing else.
+ */
 class Hash_entry {
 public:
-    Hash_entry (Hash_table *t, paddr_t tag);
-    virtual ~Hash_entry (void);
-
-    Hash_table *my_table;
     paddr_t tag;
 
-    Protocol *protocol;
+    /** The line's Line_table record in an infinite table, NULL otherwise.  */
+    Line_entry *record;
 
-    void process_request_snoop (Mreq *request);
-    void process_request_processor (Mreq *request);
+    /** A value of the protocol's state enum.  */
+    uint8_t state;
 
-    /** Debug.  */
-    void dump ();
+    /** GETS/GETM of ours for this line still waiting for the bus.  A
+     *  finite table never picks the line as a victim until they are done.  */
+    uint8_t bus_pending;
 };
 
+/** Lines the evicted table of a finite table tracks, per line it holds.  */
+#define HASH_EVICTED_RATIO      8
+
+/** Entries in the first and the largest slabs of an infinite table.  */
+#define HASH_SLAB_MIN           16
+#define HASH_SLAB_MAX           4096
+
 class Hash_table: public Module {
 public:
     /** Parameters.  */
@@ -40,6 +53,9 @@ public:
     int hit_time;
     protocol_t protocol;
 
+    /** Infinite tables never evict, finite ones are sets x assoc with LRU.  */
+    bool infinite;
+
     /** Masks for tag, index.  */
     int num_index_bits;
     int num_offset_bits;
@@ -48,32 +64,156 @@ public:
 
     Mreq *proc_request;
 
-    /** Table divided into sets which house the individual entries, indexed with index bits.  */
-    MAP<paddr_t, Hash_entry*> my_entries;
-    Hash_entry* null_entry;
+    /** Line the protocol is running a transition on, its requests to the
+     *  bus are counted in its bus_pending.  */
+    Hash_entry *active_entry;
+
+    /** Stats: whether get_entry allocated the line, and the miss type of the
+     *  current processor access should the protocol go to the bus.  */
+    bool allocated;
+    miss_type_t miss_type;
 
     /** Internal helper functions.  */
-    Hash_entry* get_entry (paddr_t addr);
+    virtual Hash_entry* get_entry (paddr_t addr) =0;
+    virtual Hash_entry* find_entry (paddr_t addr) =0;
+    int get_set (paddr_t addr) { return (int)((addr & index_mask) >> num_offset_bits); }
 
 public:
     Hash_table (ModuleID moduleID, const char *name,
                 int size, int assoc, int blocksize, int mshrs,
-                int hit_time, protocol_t protocol);
+                int hit_time, protocol_t protocol, bool infinite);
                 
-    ~Hash_table (void);
+    virtual ~Hash_table (void);
 
     void processor_request (Mreq *request);
 
     bool write_to_proc (Mreq *mreq);
     bool write_to_bus (Mreq *mreq);
+    void write_back (paddr_t addr);
 
-    void tick (void);
     void tock (void);
 
     /** Debug.  */
     void print_config (void);
+    virtual void dump_hash_entry (paddr_t addr) =0;
+    virtual void dump_hash_table () =0;
+
+    /** Stats.  State names are NULL terminated and indexed by state.  */
+    virtual const char **state_names (void) =0;
+    virtual void count_states (counter_t *states) =0;
+
+    /** Debug.  State of the line at addr, -1 when not cached.  */
+    virtual int line_state (paddr_t addr) =0;
+};
+
+/**
+ * Hash_table specialized on the coherence protocol class P, picked once in
+ * Node::build_processor.  Lines hold only their state; a single P per table
+ * runs the transitions, loaded with a line's state before each request and
+ * stored back after it.  Requests are dispatched with a qualified call into
+ * P, whose do_* transitions are inlined into its process_* switch, so there
+ * is no virtual call per access.  Instantiated in hash_table.cpp.
+ */
+template <class P>
+class Protocol_hash_table : public Hash_table {
+public:
+    Protocol_hash_table (ModuleID moduleID, const char *name,
+                         int size, int assoc, int blocksize, int mshrs,
+                         int hit_time, protocol_t protocol, bool infinite);
+    ~Protocol_hash_table (void);
+
+    /** Infinite table: every line ever touched, keyed on line address.
+     *  Entries are carved out of slabs, so they sit together in memory and
+     *  never move; a slab holds twice the entries of the one before, up to
+     *  HASH_SLAB_MAX.  */
+    Line_map<Hash_entry*> my_entries;
+    VECTOR<Hash_entry*> slabs;
+    int slab_size;
+    int slab_used;
+
+    /** Finite table divided into sets which house the individual entries,
+     *  indexed with index bits.  Way set * assoc + i, whose entry is
+     *  reused for every line the way holds; tag LINE_MAP_EMPTY when empty.  */
+    Hash_entry *ways;
+    counter_t *last_use;
+    counter_t lru_clock;
+
+    /** Stats: lines evicted from a finite table, to tell capacity from
+     *  coherence misses.  Direct mapped over HASH_EVICTED_RATIO times the
+     *  lines of the cache, a slot holds the line address plus one if the
+     *  line was still valid, and is cleared when the line comes back.  A
+     *  later eviction may take the slot first, that line's miss is then
+     *  counted as cold: misses with long reuse distances are undercounted
+     *  as capacity and coherence misses.  */
+    paddr_t *evicted;
+    int evicted_shift;
+    paddr_t *evicted_slot (paddr_t tag)
+    {
+        return &evicted[((tag >> num_offset_bits) * 0x9e3779b97f4a7c15ULL) >> evicted_shift];
+    }
+    void alloc_evicted (void);
+
+    /** Runs P's transitions, holds no line of its own.  */
+    P machine;
+
+    /** State of a line that was never touched, P's initial state.  */
+    uint8_t initial_state;
+
+    Hash_entry* get_entry (paddr_t addr);
+    Hash_entry* find_entry (paddr_t addr);
+    Hash_entry* replace_entry (paddr_t addr);
+    Hash_entry* get_infinite_entry (paddr_t addr);
+    void init_entry (Hash_entry *entry, paddr_t addr)
+    {
+        entry->tag = addr;
+        entry->record = NULL;
+        entry->state = initial_state;
+        entry->bus_pending = 0;
+    }
+
+    /** Per protocol state queries, specialized in hash_table.cpp.  */
+    static bool state_valid (int state);
+    static bool state_dirty (int state);
+
+    /** The protocol's state enum is a different type in every P.  */
+    template <class S>
+    static void load_state (S *protocol_state, uint8_t state) { *protocol_state = (S)state; }
+
+    /** One transition of the entry's line.  */
+    void process_cache_request (Hash_entry *entry, Mreq *request)
+    {
+        load_state (&machine.state, entry->state);
+        active_entry = entry;
+        machine.P::process_cache_request (request);
+        active_entry = NULL;
+        entry->state = machine.state;
+    }
+
+    void process_snoop_request (Hash_entry *entry, Mreq *request)
+    {
+        load_state (&machine.state, entry->state);
+        active_entry = entry;
+        machine.P::process_snoop_request (request);
+        active_entry = NULL;
+        entry->state = machine.state;
+    }
+
+    /** Copies the entry's state into its Line_table record.  */
+    void publish_state (Hash_entry *entry)
+    {
+        if (entry->record)
+            entry->record->set_state (moduleID.nodeID, entry->state);
+    }
+
+    void tick (void);
+    void count_access (Hash_entry *entry, Mreq *request);
+
+    void dump_entry (paddr_t tag, uint8_t state);
     void dump_hash_entry (paddr_t addr);
     void dump_hash_table ();
+    const char **state_names (void);
+    void count_states (counter_t *states);
+    int line_state (paddr_t addr);
 };
 
 #endif /** HASH_TABLE_H_*/
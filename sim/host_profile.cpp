@@ -0,0 +1,126 @@
+#include <stdio.h>
+
+#include "host_profile.h"
+#include "processor.h"
+#include "settings.h"
+#include "sim.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+const char *host_phase_str[HOST_NUM_PHASES] = {"Bus::tick", "cache tick", "processor tick",
+                                               "MC tick", "processor tock", "main loop"};
+
+/***************************************************************************
+ * Host_profile constructor, destructor, and functions.
+ ***************************************************************************/
+Host_profile::Host_profile (timestamp_t heartrate)
+{
+    /** heartrate 0 keeps the profile without heartbeats.  */
+    this->heartrate = heartrate;
+    next_beat = heartrate ? heartrate : ~(timestamp_t)0;
+
+    for (int i = 0; i < HOST_NUM_PHASES; i++)
+        ticks[i] = 0;
+    start_nsecs = beat_nsecs = host_nsecs ();
+    last_tick = host_ticks ();
+
+    beat_clock = 0;
+    beat_transactions = 0;
+    beat_references = 0;
+}
+
+Host_profile::~Host_profile ()
+{
+}
+
+/** Scaled down to at most 4 digits with a k, M or G suffix.  */
+static const char *rate_str (double rate, char *buf, size_t size)
+{
+    static const char *units[] = {"", "k", "M", "G"};
+    int i = 0;
+
+    while (rate >= 10000.0 && i < 3)
+    {
+        rate /= 1000.0;
+        i++;
+    }
+    snprintf (buf, size, "%.1f%s", rate, units[i]);
+    return buf;
+}
+
+/** h:mm:ss left if the rest of the trace bytes go as fast as the first.  */
+static const char *eta_str (double elapsed, uint64_t consumed, uint64_t total,
+                            char *buf, size_t size)
+{
+    if (!consumed || consumed > total)
+        return "-";
+
+    unsigned long long left = (unsigned long long)(elapsed * (total - consumed) / consumed);
+    snprintf (buf, size, "%llu:%02llu:%02llu", left / 3600, left / 60 % 60, left % 60);
+    return buf;
+}
+
+void Host_profile::beat (timestamp_t now)
+{
+    uint64_t nsecs = host_nsecs ();
+    double secs = (nsecs - beat_nsecs) / 1e9;
+    double elapsed = (nsecs - start_nsecs) / 1e9;
+    counter_t transactions = Sim->bus->transactions;
+    counter_t references = Sim->cache_accesses.value ();
+    uint64_t consumed = 0, total = 0;
+    char cycles_buf[16], trans_buf[16], refs_buf[16], eta_buf[32];
+    int done = 0;
+
+    if (secs <= 0.0)
+        secs = 1e-9;
+    for (int i = 0; i < settings.num_nodes; i++)
+    {
+        Processor *pr = Sim->get_PR (i);
+
+        if (pr->done ())
+            done++;
+        consumed += pr->done () ? pr->trace->file_size : pr->trace->bytes_read ();
+        total += pr->trace->file_size;
+    }
+
+    fprintf (stderr, "Heartbeat: cycle %llu, %.1f s, %s cycles/s, %s bus trans/s, %s refs/s, "
+             "%llu refs, %d/%d cores done, %.1f%% of trace, ETA %s\n",
+             (unsigned long long)now, elapsed,
+             rate_str ((now - beat_clock) / secs, cycles_buf, sizeof (cycles_buf)),
+             rate_str ((transactions - beat_transactions) / secs, trans_buf, sizeof (trans_buf)),
+             rate_str ((references - beat_references) / secs, refs_buf, sizeof (refs_buf)),
+             (unsigned long long)references, done, settings.num_nodes,
+             total ? 100.0 * consumed / total : 100.0,
+             eta_str (elapsed, consumed, total, eta_buf, sizeof (eta_buf)));
+
+    beat_nsecs = nsecs;
+    beat_clock = now;
+    beat_transactions = transactions;
+    beat_references = references;
+
+    /** Idle cycles are skipped, so catch up past now.  */
+    next_beat = (now / heartrate + 1) * heartrate;
+}
+
+void Host_profile::dump (timestamp_t now)
+{
+    double secs = (host_nsecs () - start_nsecs) / 1e9;
+    uint64_t total = 0;
+    char buf[16];
+
+    for (int i = 0; i < HOST_NUM_PHASES; i++)
+        total += ticks[i];
+    if (!total)
+        total = 1;
+    if (secs <= 0.0)
+        secs = 1e-9;
+
+    fprintf (stderr, "\nHost Profile: %.3f s, %s cycles/s\n", secs,
+             rate_str (now / secs, buf, sizeof (buf)));
+    for (int i = 0; i < HOST_NUM_PHASES; i++)
+        fprintf (stderr, "  %-16s %10.3f s %6.1f%%\n", host_phase_str[i],
+                 secs * ticks[i] / total, 100.0 * ticks[i] / total);
+    fprintf (stderr, "  Mreq pool        %10llu messages\n",
+             (unsigned long long)Sim->mreq_pool->get_pooled ());
+}
@@ -0,0 +1,93 @@
+#ifndef HOST_PROFILE_H_
+#define HOST_PROFILE_H_
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "types.h"
+
+/** Where the simulator thread spends host time, one run_cycle at a time.  */
+typedef enum {
+    HOST_BUS = 0,           /** Bus::tick.  */
+    HOST_CACHE,             /** Cache ticks, all nodes.  */
+    HOST_PR,                /** Processor ticks.  */
+    HOST_MC,                /** Memory controller ticks.  */
+    HOST_TOCK,              /** Processor tocks.  */
+    HOST_LOOP,              /** Event wheel, done check, heartbeat, ...  */
+    HOST_NUM_PHASES
+} host_phase_t;
+
+extern const char *host_phase_str[HOST_NUM_PHASES];
+
+/** Nanoseconds of the monotonic clock.  */
+static inline uint64_t host_nsecs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** Cheapest timestamp going: the TSC, else the monotonic clock.  */
+static inline uint64_t host_ticks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc ();
+#else
+    return host_nsecs ();
+#endif
+}
+
+/**
+ * Host side instrumentation of the simulator.  Every heartrate simulated
+ * cycles a heartbeat line gives the rates of the last interval on stderr,
+ * with the share of the trace bytes read so far and the finish time that
+ * extrapolates to, and at the end the host time of each phase of run_cycle
+ * is broken down.  Phases are timed with back to back TSC reads, converted
+ * to seconds against the monotonic clock over the whole run.  With node
+ * workers a phase is the wall time the simulator thread waits for all of
+ * them.
+ */
+class Host_profile {
+public:
+    Host_profile (timestamp_t heartrate);
+    ~Host_profile ();
+
+    /** Host time since the previous mark goes to phase.  */
+    void mark (host_phase_t phase)
+    {
+        uint64_t now = host_ticks ();
+
+        ticks[phase] += now - last_tick;
+        last_tick = now;
+    }
+
+    /** Beats for every heartrate cycles passed by cycle now.  */
+    void heartbeat (timestamp_t now)
+    {
+        if (now >= next_beat)
+            beat (now);
+    }
+
+    void dump (timestamp_t now);
+
+private:
+    timestamp_t heartrate;
+    timestamp_t next_beat;
+
+    uint64_t ticks[HOST_NUM_PHASES];
+    uint64_t last_tick;
+    uint64_t start_nsecs;
+
+    /** At the previous heartbeat.  */
+    uint64_t beat_nsecs;
+    timestamp_t beat_clock;
+    counter_t beat_transactions;
+    counter_t beat_references;
+
+    void beat (timestamp_t now);
+};
+
+#endif /*HOST_PROFILE_H_*/
@@ -0,0 +1,143 @@
+#ifndef LINE_MAP_H_
+#define LINE_MAP_H_
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "types.h"
+
+/** Tag of an unused slot, never a line address.  */
+#define LINE_MAP_EMPTY          (~(paddr_t)0)
+
+/** Slots of a new map, a power of two.  */
+#define LINE_MAP_MIN_SLOTS      64
+
+/**
+ * Open addressing map from line address to a small value (an entry
+ * pointer), for the lines of an infinite cache.  One flat array of {tag,
+ * value} slots probed linearly with Robin Hood ordering: a key never sits
+ * further from its home slot than the keys it passed, so a lookup compares
+ * tags in consecutive slots and gives up as soon as it meets a slot closer
+ * to home than it is.  Lines are never removed, so there are no tombstones.
+ * Values move when the array grows, callers keep the values, not pointers
+ * to them.
+ */
+template <class V>
+class Line_map {
+public:
+    typedef struct {
+        paddr_t tag;
+        V value;
+    } slot_t;
+
+    Line_map ()
+    {
+        num_entries = 0;
+        alloc (LINE_MAP_MIN_SLOTS);
+    }
+
+    ~Line_map ()
+    {
+        free (slots);
+    }
+
+    V *find (paddr_t addr)
+    {
+        size_t pos = home (addr);
+
+        for (size_t dist = 0; ; dist++, pos = (pos + 1) & mask)
+        {
+            slot_t *slot = &slots[pos];
+
+            if (slot->tag == addr)
+                return &slot->value;
+            if (slot->tag == LINE_MAP_EMPTY || ((pos - home (slot->tag)) & mask) < dist)
+                return NULL;
+        }
+    }
+
+    /** addr must not be in the map yet.  */
+    void insert (paddr_t addr, V value)
+    {
+        /** Grow at 7/8 full, Robin Hood keeps probes short up to there.  */
+        if ((num_entries + 1) * 8 > (mask + 1) * 7)
+            grow ();
+        place (addr, value);
+        num_entries++;
+    }
+
+    size_t size (void) { return num_entries; }
+
+    /** For walking every entry, unused slots have tag LINE_MAP_EMPTY.  */
+    size_t num_slots (void) { return mask + 1; }
+    slot_t *slot (size_t i) { return &slots[i]; }
+
+private:
+    slot_t *slots;
+    size_t mask;
+    int shift;
+    size_t num_entries;
+
+    /** Fibonacci hashing, the top bits of the product mix in every bit of
+     *  the address, line offset zeros included.  */
+    size_t home (paddr_t addr)
+    {
+        return (size_t)((addr * 0x9e3779b97f4a7c15ULL) >> shift);
+    }
+
+    void alloc (size_t num_slots)
+    {
+        slots = (slot_t *)malloc (num_slots * sizeof (slot_t));
+        assert (slots && "Line_map: Unable to alloc slots.");
+        for (size_t i = 0; i < num_slots; i++)
+            slots[i].tag = LINE_MAP_EMPTY;
+        mask = num_slots - 1;
+        shift = 64 - __builtin_ctzll (num_slots);
+    }
+
+    /** Robin Hood: take the slot of any key closer to its home and carry
+     *  that one on instead.  */
+    void place (paddr_t addr, V value)
+    {
+        size_t pos = home (addr);
+
+        for (size_t dist = 0; ; dist++, pos = (pos + 1) & mask)
+        {
+            slot_t *slot = &slots[pos];
+
+            if (slot->tag == LINE_MAP_EMPTY)
+            {
+                slot->tag = addr;
+                slot->value = value;
+                return;
+            }
+
+            size_t slot_dist = (pos - home (slot->tag)) & mask;
+            if (slot_dist < dist)
+            {
+                paddr_t tag = slot->tag;
+                V displaced = slot->value;
+
+                slot->tag = addr;
+                slot->value = value;
+                addr = tag;
+                value = displaced;
+                dist = slot_dist;
+            }
+        }
+    }
+
+    void grow (void)
+    {
+        slot_t *old = slots;
+        size_t old_slots = mask + 1;
+
+        alloc (old_slots * 2);
+        for (size_t i = 0; i < old_slots; i++)
+            if (old[i].tag != LINE_MAP_EMPTY)
+                place (old[i].tag, old[i].value);
+        free (old);
+    }
+};
+
+#endif /* LINE_MAP_H_ */
@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "line_table.h"
+#include "settings.h"
+#include "sim.h"
+
+extern Sim_settings settings;
+
+/***************************************************************************
+ * Line_entry constructor, destructor.
+ ***************************************************************************/
+Line_entry::Line_entry ()
+{
+    states = NULL;
+}
+
+Line_entry::~Line_entry ()
+{
+}
+
+/***************************************************************************
+ * Line_table constructor, destructor, and functions.
+ ***************************************************************************/
+Line_table::Line_table ()
+{
+    if (settings.num_nodes > LINE_PRESENCE_WORDS * 64)
+        fatal_error ("Line_table hard coded to %d nodes..  fix .h file!", LINE_PRESENCE_WORDS * 64);
+
+    words_per_line = (settings.num_nodes + LINE_STATES_PER_WORD - 1) / LINE_STATES_PER_WORD;
+    slabs.clear ();
+    state_slabs.clear ();
+    slab_used = LINE_SLAB_LINES;
+}
+
+Line_table::~Line_table ()
+{
+    for (unsigned int i = 0; i < slabs.size (); i++)
+    {
+        delete [] slabs[i];
+        free (state_slabs[i]);
+    }
+}
+
+/** Entries never move once inserted, callers may keep the pointer.  */
+Line_entry *Line_table::find (paddr_t addr)
+{
+    Line_entry **found = lines.find (addr);
+
+    return found ? *found : NULL;
+}
+
+Line_entry *Line_table::get (paddr_t addr)
+{
+    Line_entry **found = lines.find (addr);
+    Line_entry *line;
+
+    if (found)
+        return *found;
+
+    if (slab_used == LINE_SLAB_LINES)
+    {
+        uint64_t *states = (uint64_t *)calloc (LINE_SLAB_LINES * words_per_line, sizeof (uint64_t));
+
+        assert (states && "Line_table: Unable to alloc state vectors.");
+        slabs.push_back (new Line_entry[LINE_SLAB_LINES]);
+        state_slabs.push_back (states);
+        slab_used = 0;
+    }
+    line = &slabs.back ()[slab_used];
+    line->states = &state_slabs.back ()[slab_used * words_per_line];
+    slab_used++;
+
+    lines.insert (addr, line);
+    return line;
+}
+
+void Line_table::get_lines (VECTOR<paddr_t> *addrs)
+{
+    addrs->clear ();
+    for (size_t i = 0; i < lines.num_slots (); i++)
+        if (lines.slot (i)->tag != LINE_MAP_EMPTY)
+            addrs->push_back (lines.slot (i)->tag);
+    sort (addrs->begin (), addrs->end ());
+}
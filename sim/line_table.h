@@ -0,0 +1,88 @@
+#ifndef LINE_TABLE_H_
+#define LINE_TABLE_H_
+
+#include <assert.h>
+
+#include "line_map.h"
+#include "types.h"
+
+/** Words in a per-core bit vector, matches the 512 node limit of Sharers.  */
+#define LINE_PRESENCE_WORDS     8
+
+/** A line's state in each cache, packed LINE_STATE_BITS to a core.  The
+ *  protocol state is kept plus one, LINE_STATE_NONE means no entry.  */
+#define LINE_STATE_BITS         4
+#define LINE_STATE_MASK         ((1 << LINE_STATE_BITS) - 1)
+#define LINE_STATES_PER_WORD    (64 / LINE_STATE_BITS)
+#define LINE_STATE_NONE         0
+
+/** Lines whose records and state vectors a Line_table carves out of one
+ *  allocation.  */
+#define LINE_SLAB_LINES         4096
+
+/** Per line record: the state of the line in every cache.  */
+class Line_entry {
+public:
+    Line_entry ();
+    ~Line_entry ();
+
+    /** Owned by the Line_table, one nibble per core.  */
+    uint64_t *states;
+
+    /** Protocol state of the line in nodeID's cache, -1 if it has no entry.  */
+    int get_state (int nodeID)
+    {
+        uint64_t word = __atomic_load_n (&states[nodeID / LINE_STATES_PER_WORD], __ATOMIC_RELAXED);
+
+        return (int)((word >> ((nodeID % LINE_STATES_PER_WORD) * LINE_STATE_BITS)) & LINE_STATE_MASK) - 1;
+    }
+
+    /** Only ever called by the owning core, so the xor leaves every other
+     *  nibble alone even with parallel node workers on the same word.  */
+    void set_state (int nodeID, int state)
+    {
+        uint64_t *word = &states[nodeID / LINE_STATES_PER_WORD];
+        int shift = (nodeID % LINE_STATES_PER_WORD) * LINE_STATE_BITS;
+        uint64_t old = (__atomic_load_n (word, __ATOMIC_RELAXED) >> shift) & LINE_STATE_MASK;
+
+        assert (state >= 0 && state < LINE_STATE_MASK);
+        if (old != (uint64_t)state + 1)
+            __atomic_fetch_xor (word, (old ^ ((uint64_t)state + 1)) << shift, __ATOMIC_RELAXED);
+    }
+};
+
+/**
+ * Process-wide, line-major table of every line an infinite L1 holds, with
+ * the line's packed per-core state vector.  The bus probes it once per
+ * transaction, and each snooper reads its own state from the record: only
+ * caches holding the line in a state other than I look up their entry and
+ * run the protocol, everyone else neither looks it up nor allocates it.
+ * Finite L1s find lines in their own sets and do not use it.
+ *
+ * A Line_map from address to record, with records and state vectors carved
+ * out of slabs so they never move.  Only the bus, in the serial phase of a
+ * cycle, looks lines up and adds them, so there is no lock; caches only
+ * read and write their own state in records the bus handed them.
+ */
+class Line_table {
+public:
+    Line_table ();
+    ~Line_table ();
+
+    Line_entry *find (paddr_t addr);
+    Line_entry *get (paddr_t addr);
+
+    /** All lines in address order.  */
+    void get_lines (VECTOR<paddr_t> *addrs);
+
+private:
+    Line_map<Line_entry*> lines;
+
+    /** Records, and their state vectors of words_per_line words each.  */
+    int words_per_line;
+    VECTOR<Line_entry *> slabs;
+    VECTOR<uint64_t *> state_slabs;
+    int slab_used;
+};
+
+#endif /* LINE_TABLE_H_ */
@@ -0,0 +1,209 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SIM_LOG_ZLIB
+#include <zlib.h>
+#endif
+
+#include "log_sink.h"
+#include "sim.h"
+
+/***************************************************************************
+ * Log_sink constructor, destructor, and functions.
+ ***************************************************************************/
+Log_sink::Log_sink (const char *path)
+{
+    size_t path_len = strlen (path);
+
+    outfile = NULL;
+    gzfile = NULL;
+
+    if (path_len > 3 && !strcmp (path + path_len - 3, ".gz"))
+    {
+#ifdef SIM_LOG_ZLIB
+        gzfile = gzopen (path, "wb");
+        if (!gzfile)
+            fatal_error ("Log_sink: Unable to create %s\n", path);
+#else
+        fatal_error ("Log_sink: %s needs a build with -DSIM_LOG_ZLIB\n", path);
+#endif
+    }
+    else
+    {
+        outfile = fopen (path, "w");
+        if (!outfile)
+            fatal_error ("Log_sink: Unable to create %s\n", path);
+    }
+
+    for (int i = 0; i < LOG_SINK_BUFFERS; i++)
+    {
+        Log_buffer *buf = new Log_buffer;
+        buf->data = (char *)malloc (LOG_SINK_BUFFER_SIZE);
+        assert (buf->data && "Log_sink: Unable to alloc buffer.");
+        buf->len = 0;
+        free_buffers.push_back (buf);
+    }
+    front = free_buffers.front ();
+    free_buffers.pop_front ();
+
+    writer_busy = false;
+    stop = false;
+    pthread_mutex_init (&lock, NULL);
+    pthread_cond_init (&work, NULL);
+    pthread_cond_init (&done, NULL);
+
+    if (pthread_create (&writer, NULL, writer_main, this))
+        fatal_error ("Log_sink: Unable to create writer thread\n");
+}
+
+Log_sink::~Log_sink ()
+{
+    flush ();
+
+    pthread_mutex_lock (&lock);
+    stop = true;
+    pthread_cond_signal (&work);
+    pthread_mutex_unlock (&lock);
+    pthread_join (writer, NULL);
+
+    free_buffers.push_back (front);
+    while (!free_buffers.empty ())
+    {
+        free (free_buffers.front ()->data);
+        delete free_buffers.front ();
+        free_buffers.pop_front ();
+    }
+
+    pthread_mutex_destroy (&lock);
+    pthread_cond_destroy (&work);
+    pthread_cond_destroy (&done);
+
+#ifdef SIM_LOG_ZLIB
+    if (gzfile)
+        gzclose ((gzFile)gzfile);
+#endif
+    if (outfile)
+        fclose (outfile);
+}
+
+/** Queue the front buffer and take an empty one, waiting on the writer
+ *  only when every buffer is in flight.  */
+void Log_sink::hand_off (void)
+{
+    pthread_mutex_lock (&lock);
+    full_buffers.push_back (front);
+    pthread_cond_signal (&work);
+    while (free_buffers.empty ())
+        pthread_cond_wait (&done, &lock);
+    front = free_buffers.front ();
+    free_buffers.pop_front ();
+    pthread_mutex_unlock (&lock);
+
+    front->len = 0;
+}
+
+void Log_sink::write (const char *buf, size_t len)
+{
+    while (len)
+    {
+        size_t chunk = min (len, (size_t)LOG_SINK_BUFFER_SIZE - front->len);
+
+        memcpy (front->data + front->len, buf, chunk);
+        front->len += chunk;
+        buf += chunk;
+        len -= chunk;
+
+        if (front->len == LOG_SINK_BUFFER_SIZE)
+            hand_off ();
+    }
+}
+
+void Log_sink::vprintf (const char *fmt, va_list ap)
+{
+    int len;
+
+    if (LOG_SINK_BUFFER_SIZE - front->len < LOG_SINK_MAX_LINE)
+        hand_off ();
+
+    va_list aq;
+    va_copy (aq, ap);
+    len = vsnprintf (front->data + front->len, LOG_SINK_BUFFER_SIZE - front->len, fmt, aq);
+    va_end (aq);
+
+    if (len < 0)
+        return;
+
+    if ((size_t)len < LOG_SINK_BUFFER_SIZE - front->len)
+    {
+        front->len += len;
+        return;
+    }
+
+    /** Longer than what was left, format on the heap and copy in.  */
+    char *line = (char *)malloc (len + 1);
+    assert (line && "Log_sink: Unable to alloc line.");
+    vsnprintf (line, len + 1, fmt, ap);
+    write (line, len);
+    free (line);
+}
+
+void Log_sink::flush (void)
+{
+    if (front->len)
+        hand_off ();
+
+    pthread_mutex_lock (&lock);
+    while (!full_buffers.empty () || writer_busy)
+        pthread_cond_wait (&done, &lock);
+    pthread_mutex_unlock (&lock);
+
+    if (outfile)
+        fflush (outfile);
+#ifdef SIM_LOG_ZLIB
+    if (gzfile)
+        gzflush ((gzFile)gzfile, Z_SYNC_FLUSH);
+#endif
+}
+
+void Log_sink::write_out (Log_buffer *buf)
+{
+#ifdef SIM_LOG_ZLIB
+    if (gzfile)
+    {
+        gzwrite ((gzFile)gzfile, buf->data, buf->len);
+        return;
+    }
+#endif
+    fwrite (buf->data, 1, buf->len, outfile);
+}
+
+void *Log_sink::writer_main (void *arg)
+{
+    Log_sink *sink = (Log_sink *)arg;
+    Log_buffer *buf;
+
+    pthread_mutex_lock (&sink->lock);
+    while (true)
+    {
+        while (sink->full_buffers.empty () && !sink->stop)
+            pthread_cond_wait (&sink->work, &sink->lock);
+        if (sink->full_buffers.empty ())
+            break;
+
+        buf = sink->full_buffers.front ();
+        sink->full_buffers.pop_front ();
+        sink->writer_busy = true;
+        pthread_mutex_unlock (&sink->lock);
+
+        sink->write_out (buf);
+
+        pthread_mutex_lock (&sink->lock);
+        sink->writer_busy = false;
+        sink->free_buffers.push_back (buf);
+        pthread_cond_broadcast (&sink->done);
+    }
+    pthread_mutex_unlock (&sink->lock);
+    return NULL;
+}
@@ -0,0 +1,64 @@
+#ifndef LOG_SINK_H_
+#define LOG_SINK_H_
+
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "types.h"
+
+/** Size and number of buffers cycling between simulator and writer.  */
+#define LOG_SINK_BUFFER_SIZE    (4 << 20)
+#define LOG_SINK_BUFFERS        4
+
+/** Longest single sim_printf formatted without a heap detour.  */
+#define LOG_SINK_MAX_LINE       4096
+
+class Log_buffer {
+public:
+    char *data;
+    size_t len;
+};
+
+/**
+ * Simulator output sent to a file by a dedicated writer thread.  The
+ * simulator formats into the front buffer; a full buffer is queued for the
+ * writer and an empty one taken back, waiting only if the writer is
+ * LOG_SINK_BUFFERS behind.  Parallel node workers keep their own buffers
+ * and flush them through write () in node order, so the file holds exactly
+ * what stderr would have.  Paths ending in ".gz" are gzip compressed when
+ * built with -DSIM_LOG_ZLIB.
+ */
+class Log_sink {
+public:
+    Log_sink (const char *path);
+    ~Log_sink ();
+
+    void write (const char *buf, size_t len);
+    void vprintf (const char *fmt, va_list ap);
+
+    /** Returns once everything written so far is in the file.  */
+    void flush (void);
+
+private:
+    FILE *outfile;
+    void *gzfile;
+
+    Log_buffer *front;
+
+    LIST<Log_buffer*> full_buffers;
+    LIST<Log_buffer*> free_buffers;
+    bool writer_busy;
+    bool stop;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+
+    void hand_off (void);
+    void write_out (Log_buffer *buf);
+
+    static void *writer_main (void *arg);
+};
+
+#endif /*LOG_SINK_H_*/
@@ -19,7 +19,26 @@ void usage (void)
 {
     fprintf (stderr, "Usage:\n");
     fprintf (stderr, "\t-p <protocol> (choices MI, MSI, MESI)\n");
-    fprintf (stderr, "\t-t <trace directory>\n\n");
+    fprintf (stderr, "\t-t <trace directory>\n");
+    fprintf (stderr, "\t-j <host threads> (default 1)\n");
+    fprintf (stderr, "\t-c <L1 size in bytes> (finite L1, default infinite)\n");
+    fprintf (stderr, "\t-a <L1 associativity> (finite L1, default infinite)\n");
+    fprintf (stderr, "\t-m (mmap text traces instead of reading them with stdio)\n");
+    fprintf (stderr, "\t-f <decoder threads> (decode traces ahead of the processors, default 0)\n");
+    fprintf (stderr, "\t-l <log level> (choices quiet, validation, debug; default validation)\n");
+    fprintf (stderr, "\t-o <log file> (write output there from a writer thread, .gz compresses)\n");
+    fprintf (stderr, "\t-e <event log> (record events in a binary ring file, decode with simlog)\n");
+    fprintf (stderr, "\t-D <digest file> (record a digest of the event stream)\n");
+    fprintf (stderr, "\t-d <digest file> (check the event stream against a recorded digest)\n");
+    fprintf (stderr, "\t-r <report file> (per core stats report, JSON for .json, else CSV)\n");
+    fprintf (stderr, "\t-s <series file> (CSV time series of the stats, one row per interval)\n");
+    fprintf (stderr, "\t-i <cycles> (time series interval, default 1024)\n");
+    fprintf (stderr, "\t-S <bytes> (classify sharing patterns of regions this size, 0 for a line)\n");
+    fprintf (stderr, "\t-b <cycles> (heartbeat every so many cycles and host time per phase, 0 for 65536)\n");
+    fprintf (stderr, "\t-w <addr>[,<addr>...] (keep the last bus events of these lines, kill -USR1 to dump)\n");
+    fprintf (stderr, "\t-k <lines> (report the most contended lines, default 0)\n");
+    fprintf (stderr, "\t-T <trace file> (Chrome trace JSON of bus and memory transactions)\n");
+    fprintf (stderr, "\t-W <start>:<end> (cycle window of the Chrome trace, default whole run)\n\n");
 }
 
 int main (int argc, char *argv[])
@@ -30,11 +49,30 @@ int main (int argc, char *argv[])
     FILE *config_file = NULL;
     char config_path[1000];
     bool debug = false;
+    int sim_threads = 1;
+    int l1_size = 0;
+    int l1_assoc = 0;
+    bool trace_mmap = false;
+    int trace_prefetch = 0;
+    char *log_level = NULL;
+    char *log_file = NULL;
+    char *event_log = NULL;
+    char *digest_file = NULL;
+    bool digest_record = false;
+    char *report_file = NULL;
+    char *series_file = NULL;
+    long long sampling_interval = 0;
+    int hot_lines = 0;
+    int sharing_gran = -1;
+    char *watch_addrs = NULL;
+    long long heartrate = -1;
+    char *trace_export = NULL;
+    unsigned long long export_start = 0, export_end = ~0ULL;
 
     /** Parse command line arguments.  */
     int c;
 
-    while ((c = getopt(argc, argv, "hP:p:t:")) != -1)
+    while ((c = getopt(argc, argv, "hP:p:t:j:c:a:mf:l:o:e:d:D:r:s:i:S:w:b:k:T:W:")) != -1)
     {
         switch(c)
         {
@@ -51,6 +89,90 @@ int main (int argc, char *argv[])
             trace_dir = strdup (optarg);
             break;
 
+        case 'j':
+            sim_threads = atoi (optarg);
+            break;
+
+        case 'c':
+            l1_size = atoi (optarg);
+            break;
+
+        case 'a':
+            l1_assoc = atoi (optarg);
+            break;
+
+        case 'm':
+            trace_mmap = true;
+            break;
+
+        case 'f':
+            trace_prefetch = atoi (optarg);
+            break;
+
+        case 'l':
+            log_level = strdup (optarg);
+            break;
+
+        case 'o':
+            log_file = strdup (optarg);
+            break;
+
+        case 'e':
+            event_log = strdup (optarg);
+            break;
+
+        case 'd':
+        case 'D':
+            digest_file = strdup (optarg);
+            digest_record = (c == 'D');
+            break;
+
+        case 'r':
+            report_file = strdup (optarg);
+            break;
+
+        case 's':
+            series_file = strdup (optarg);
+            break;
+
+        case 'i':
+            sampling_interval = atoll (optarg);
+            if (sampling_interval <= 0)
+                fatal_error ("Error: invalid sampling interval - %s\n", optarg);
+            break;
+
+        case 'S':
+            sharing_gran = atoi (optarg);
+            if (sharing_gran < 0 || !ISPOW2 (sharing_gran))
+                fatal_error ("Error: invalid sharing region size - %s\n", optarg);
+            break;
+
+        case 'b':
+            heartrate = atoll (optarg);
+            if (heartrate < 0 || heartrate > 0xffffffffLL)
+                fatal_error ("Error: invalid heartrate - %s\n", optarg);
+            break;
+
+        case 'w':
+            watch_addrs = optarg;
+            break;
+
+        case 'k':
+            hot_lines = atoi (optarg);
+            if (hot_lines < 0)
+                fatal_error ("Error: invalid number of contended lines - %s\n", optarg);
+            break;
+
+        case 'T':
+            trace_export = strdup (optarg);
+            break;
+
+        case 'W':
+            if (sscanf (optarg, "%llu:%llu", &export_start, &export_end) != 2 ||
+                export_end < export_start)
+                fatal_error ("Error: invalid cycle window - %s\n", optarg);
+            break;
+
         default:
             fprintf (stderr, "Invalid command line arguments - %c", c);
             usage ();
@@ -81,6 +203,82 @@ int main (int argc, char *argv[])
     settings.num_nodes = num_nodes;
     settings.trace_dir = trace_dir;
 
+    if (sim_threads < 1)
+        fatal_error ("Error: invalid number of host threads - %d\n", sim_threads);
+    settings.sim_threads = sim_threads;
+    settings.trace_mmap = trace_mmap;
+
+    if (trace_prefetch < 0)
+        fatal_error ("Error: invalid number of decoder threads - %d\n", trace_prefetch);
+    settings.trace_prefetch = trace_prefetch;
+
+    if (log_level == NULL || !strcmp(log_level,"validation"))
+    {
+        settings.log_level = LOG_VALIDATION;
+    }
+    else if (!strcmp(log_level,"quiet"))
+    {
+        settings.log_level = LOG_QUIET;
+    }
+    else if (!strcmp(log_level,"debug"))
+    {
+        settings.log_level = LOG_DEBUG;
+    }
+    else
+    {
+        fatal_error ("Error: invalid log level - %s\n", log_level);
+    }
+
+    settings.log_file = log_file;
+    settings.event_log = event_log;
+    settings.digest_file = digest_file;
+    settings.digest_record = digest_record;
+
+    settings.series_file = series_file;
+    settings.hot_lines = hot_lines;
+    settings.watch_addrs = watch_addrs;
+    if (heartrate >= 0)
+    {
+        settings.host_profile = true;
+        if (heartrate > 0)
+            settings.heartrate = heartrate;
+    }
+
+    /** Regions smaller than a line can't be told apart on the bus.  */
+    if (sharing_gran >= 0)
+    {
+        settings.sim_analysis_enabled = true;
+        settings.ro_tracker_gran = max ((unsigned int)sharing_gran, settings.cache_line_size);
+    }
+
+    settings.trace_export = trace_export;
+    settings.trace_export_start = export_start;
+    settings.trace_export_end = export_end;
+    if (sampling_interval)
+        settings.sampling_interval = sampling_interval;
+
+    /** The report format follows the file name.  */
+    if (report_file)
+    {
+        size_t len = strlen (report_file);
+
+        settings.report_file = report_file;
+        if (len > 5 && !strcmp (report_file + len - 5, ".json"))
+            settings.report_output = OUTPUT_FMT_JSON;
+        else
+            settings.report_output = OUTPUT_FMT_CSV;
+    }
+
+    /** Either L1 option switches to a finite cache.  */
+    if (l1_size || l1_assoc)
+    {
+        settings.l1_infinite = false;
+        if (l1_size)
+            settings.l1_cache_size = l1_size;
+        if (l1_assoc)
+            settings.l1_cache_assoc = l1_assoc;
+    }
+
     if (!strcmp(protocol,"MI"))
     {
     	settings.protocol = MI_PRO;
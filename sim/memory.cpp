@@ -9,6 +9,7 @@ Memory_controller::Memory_controller(ModuleID moduleID, int hit_time)
 	this->hit_time = hit_time;
 	request_in_progress = false;
 	data_time = 0;
+	request_time = 0;
 	data_target = (ModuleID){-1,INVALID_M};
 }
 
@@ -24,14 +25,34 @@ void Memory_controller::tick()
     {
 		if (request->msg != DATA)
 		{
+			if (Sim->stats)
+				Sim->stats->mem.requests[request->msg]++;
 			assert (!request_in_progress);
 			request_in_progress = true;
+			request_time = Global_Clock;
 			data_addr = request->addr;
 			data_target = request->src_mid;
 			data_time = Global_Clock + hit_time;
+			/** A zero hit_time replies below in this tick, the wakeup
+			 *  can only go to a later cycle.  */
+			Sim->schedule (data_time > Global_Clock ? data_time : Global_Clock + 1);
+		}
+		else if (request->dest_mid == moduleID)
+		{
+			/** Writeback from an L1 eviction, absorbed.  */
+			if (Sim->stats)
+				Sim->stats->mem.writebacks++;
 		}
 		else
 		{
+			/** A cache supplied the data, the memory response is dropped.  */
+			if (Sim->stats && request_in_progress)
+			{
+				Sim->stats->mem.cancelled++;
+				Sim->stats->mem.busy_cycles += Global_Clock - request_time;
+			}
+			if (Sim->trace_export && request_in_progress)
+				Sim->trace_export->mc_service (request_time, data_addr, true);
 			request_in_progress = false;
 		}
     }
@@ -41,7 +62,14 @@ void Memory_controller::tick()
     	Mreq * new_request;
     	new_request = new Mreq(DATA,data_addr,moduleID,data_target);
     	request_in_progress = false;
-    	fprintf(stderr,"**** DATA SEND MC -- Clock: %lld\n",Global_Clock);
+    	if (Sim->stats)
+    	{
+    		Sim->stats->mem.responses++;
+    		Sim->stats->mem.busy_cycles += Global_Clock - request_time;
+    	}
+    	if (Sim->trace_export)
+    		Sim->trace_export->mc_service (request_time, data_addr, false);
+    	SIM_EVENT (LOG_VALIDATION, EV_MC_DATA_SEND, moduleID, new_request);
     	this->write_output_port(new_request);
     }
 }
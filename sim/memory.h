@@ -22,6 +22,8 @@ public:
 
     bool request_in_progress;
     timestamp_t data_time;
+    /** Cycle the request in progress arrived.  */
+    timestamp_t request_time;
     paddr_t data_addr;
     ModuleID data_target;
 
@@ -47,6 +47,7 @@ public:
 	Module (ModuleID moduleID, const char *name);
 	virtual ~Module();
 
+    /** Returns the bus-owned current request, valid for this cycle only.  */
  	Mreq *read_input_port (void);
     bool write_output_port (Mreq *mreq);
 
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "mreq.h"
 #include "settings.h"
@@ -30,14 +31,137 @@ Mreq::~Mreq(void)
 {
 }
 
+void *Mreq::operator new (size_t size)
+{
+    assert (size == sizeof (Mreq));
+    return Sim->mreq_pool->acquire ();
+}
+
+void Mreq::operator delete (void *ptr)
+{
+    if (ptr)
+        Sim->mreq_pool->release (ptr);
+}
+
+/***************************************************************************
+ * Mreq_pool constructor, destructor, and functions.
+ ***************************************************************************/
+Mreq_pool::Mreq_pool (int num_workers)
+{
+    this->num_workers = num_workers;
+    lists = new Mreq_freelist[num_workers];
+
+    for (int i = 0; i < num_workers; i++)
+    {
+        lists[i].head = NULL;
+        lists[i].slabs.clear ();
+        lists[i].acquired = 0;
+        lists[i].released = 0;
+        lists[i].remote = NULL;
+    }
+}
+
+Mreq_pool::~Mreq_pool ()
+{
+    for (int i = 0; i < num_workers; i++)
+    {
+        LIST<void*>::iterator it;
+        for (it = lists[i].slabs.begin (); it != lists[i].slabs.end (); it++)
+            free (*it);
+    }
+    delete [] lists;
+}
+
+/** Outside parallel phases the simulator thread uses worker 0's list.  */
+void *Mreq_pool::acquire (void)
+{
+    Mreq_freelist *list = &lists[sim_worker < 0 ? 0 : sim_worker];
+    void *ptr;
+
+    if (!list->head)
+        list->head = __atomic_exchange_n (&list->remote, (void *)NULL, __ATOMIC_ACQUIRE);
+    if (!list->head)
+        grow (list);
+
+    ptr = list->head;
+    list->head = *(void **)ptr;
+    list->acquired++;
+    return ptr;
+}
+
+/** Counted on the releasing thread's list, only the owner's list takes
+ *  the message back.  */
+void Mreq_pool::release (void *ptr)
+{
+    int self = sim_worker < 0 ? 0 : sim_worker;
+    int owner = *(int *)((char *)ptr - MREQ_POOL_HEADER);
+    Mreq_freelist *list = &lists[owner];
+
+    lists[self].released++;
+
+    if (owner == self)
+    {
+        *(void **)ptr = list->head;
+        list->head = ptr;
+        return;
+    }
+
+    void *head = __atomic_load_n (&list->remote, __ATOMIC_RELAXED);
+    do
+        *(void **)ptr = head;
+    while (!__atomic_compare_exchange_n (&list->remote, &head, ptr, true,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void Mreq_pool::grow (Mreq_freelist *list)
+{
+    size_t slot = MREQ_POOL_HEADER + sizeof (Mreq);
+    char *slab;
+
+    slab = (char *)malloc (MREQ_POOL_SLAB * slot);
+    if (!slab)
+        fatal_error ("Mreq_pool: Unable to alloc slab\n");
+    list->slabs.push_back (slab);
+
+    for (int i = MREQ_POOL_SLAB - 1; i >= 0; i--)
+    {
+        char *ptr = slab + i * slot + MREQ_POOL_HEADER;
+
+        *(int *)(ptr - MREQ_POOL_HEADER) = list - lists;
+        *(void **)ptr = list->head;
+        list->head = ptr;
+    }
+}
+
+counter_t Mreq_pool::get_live (void)
+{
+    counter_t acquired = 0, released = 0;
+
+    for (int i = 0; i < num_workers; i++)
+    {
+        acquired += lists[i].acquired;
+        released += lists[i].released;
+    }
+    return acquired - released;
+}
+
+counter_t Mreq_pool::get_pooled (void)
+{
+    counter_t pooled = 0;
+
+    for (int i = 0; i < num_workers; i++)
+        pooled += (counter_t)lists[i].slabs.size () * MREQ_POOL_SLAB;
+    return pooled;
+}
+
 void Mreq::print_msg (ModuleID mid, const char *add_msg)
 {
     //TODO: convert fprintfs to c++-ishy output
     print_id ("node", mid);
     print_id ("src", src_mid);
     print_id ("dest", dest_mid);
-    fprintf (stderr, "tag: 0x%8llx clock: %8lld ", (long long int)addr>>settings.cache_line_size_log2, Global_Clock);
-    fprintf (stderr, " %8s\n", Mreq::message_t_str[msg]);
+    sim_printf ("tag: 0x%8llx clock: %8lld ", (long long int)addr>>settings.cache_line_size_log2, Global_Clock);
+    sim_printf (" %8s\n", Mreq::message_t_str[msg]);
 }
 
 void Mreq::dump ()
@@ -22,6 +22,10 @@ public:
 
 	~Mreq ();
 
+    /** Messages come from the simulator's Mreq_pool, see below.  */
+    static void *operator new (size_t size);
+    static void operator delete (void *ptr);
+
     message_t msg;
     paddr_t pc;
 	paddr_t addr;
@@ -40,4 +44,56 @@ public:
     void dump (void);
 };
 
+/** Messages carved out of each slab.  */
+#define MREQ_POOL_SLAB          1024
+
+/** Bytes in front of each message holding the index of the freelist that
+ *  carved it out, a multiple of 16 so messages stay aligned.  */
+#define MREQ_POOL_HEADER        16
+
+/** Freelist of one worker, padded so workers don't share cache lines.  */
+class Mreq_freelist {
+public:
+    void *head;
+    LIST<void*> slabs;
+    counter_t acquired;
+    counter_t released;
+    char pad[64];
+
+    /** Messages of this list freed on other threads.  Pushed with CAS by
+     *  any thread, taken back whole by the owner when head runs dry.  */
+    void *remote;
+    char remote_pad[64];
+};
+
+/**
+ * Slab allocator for Mreq.  Messages are acquired when a processor, cache
+ * or memory controller creates one and released where they are consumed:
+ * by Bus::tick, by the L1 for processor requests, and by the processor for
+ * DATA replies.  Each node worker has its own freelist and every message
+ * goes back to the list it came from, straight onto it on the owning
+ * thread and through the list's remote stack elsewhere, so a list only
+ * grows when its own messages are all in flight.
+ */
+class Mreq_pool {
+public:
+    Mreq_pool (int num_workers);
+    ~Mreq_pool ();
+
+    void *acquire (void);
+    void release (void *ptr);
+
+    /** Messages acquired and never released, over all lists.  */
+    counter_t get_live (void);
+
+    /** Messages carved out of slabs, over all lists.  */
+    counter_t get_pooled (void);
+
+private:
+    int num_workers;
+    Mreq_freelist *lists;
+
+    void grow (Mreq_freelist *list);
+};
+
 #endif /*MREQ_H_*/
@@ -3,6 +3,12 @@
 #include "hash_table.h"
 #include "memory.h"
 #include "sim.h"
+#include "../protocols/MI_protocol.h"
+#include "../protocols/MSI_protocol.h"
+#include "../protocols/MESI_protocol.h"
+#include "../protocols/MOSI_protocol.h"
+#include "../protocols/MOESI_protocol.h"
+#include "../protocols/MOESIF_protocol.h"
 
 extern Sim_settings settings;
 extern Simulator *Sim;
@@ -23,17 +29,35 @@ Node::~Node ()
     mod.clear ();
 }
 
+/** Build an L1 specialized on coherence protocol P.  */
+template <class P>
+static Hash_table *build_l1 (int nodeID)
+{
+    return new Protocol_hash_table<P> ((ModuleID){nodeID, L1_M}, "L1",
+                                       settings.l1_cache_size,
+                                       settings.l1_cache_assoc,
+                                       settings.cache_line_size,
+                                       settings.l1_mshrs,
+                                       settings.l1_hit_time,
+                                       settings.protocol,
+                                       settings.l1_infinite);
+}
+
 void Node::build_processor (char *trace_file)
 {
     Hash_table *cache;
 
-    mod[L1_M] = cache = new Hash_table ((ModuleID){nodeID, L1_M}, "L1", 
-                                        settings.l1_cache_size,
-                                        settings.l1_cache_assoc,
-                                        settings.cache_line_size,
-                                        settings.l1_mshrs,
-                                        settings.l1_hit_time,
-                                        settings.protocol);
+    switch (settings.protocol) {
+    case MI_PRO:     cache = build_l1<MI_protocol> (nodeID); break;
+    case MSI_PRO:    cache = build_l1<MSI_protocol> (nodeID); break;
+    case MESI_PRO:   cache = build_l1<MESI_protocol> (nodeID); break;
+    case MOSI_PRO:   cache = build_l1<MOSI_protocol> (nodeID); break;
+    case MOESI_PRO:  cache = build_l1<MOESI_protocol> (nodeID); break;
+    case MOESIF_PRO: cache = build_l1<MOESIF_protocol> (nodeID); break;
+    default:
+        fatal_error ("Node: Unknown coherence protocol!\n");
+    }
+    mod[L1_M] = cache;
 
     mod[PR_M] = new Processor ((ModuleID){nodeID, PR_M}, cache, trace_file);
 }
@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bus.h"
+#include "node.h"
+#include "node_pool.h"
+#include "settings.h"
+#include "sim.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+__thread int sim_worker = -1;
+
+/** Initial size of each worker's log buffer.  */
+#define NODE_WORKER_LOG_SIZE    (1 << 16)
+
+/***************************************************************************
+ * Node_worker constructor, destructor.
+ ***************************************************************************/
+Node_worker::Node_worker ()
+{
+    pool = NULL;
+    id = -1;
+    first_node = 0;
+    last_node = -1;
+
+    log_cap = NODE_WORKER_LOG_SIZE;
+    log_len = 0;
+    log_buf = (char *)malloc (log_cap);
+    assert (log_buf && "Node_worker: Unable to alloc log buffer.");
+
+    bus_requests.clear ();
+    shared_line = false;
+    wakeups.clear ();
+    events.clear ();
+}
+
+Node_worker::~Node_worker ()
+{
+    free (log_buf);
+}
+
+/***************************************************************************
+ * Node_pool constructor, destructor, and functions.
+ ***************************************************************************/
+Node_pool::Node_pool (int num_threads, int num_nodes)
+{
+    int total_nodes;
+    int num_cpus;
+
+    /** Node num_nodes holds the memory controller and is ticked too.  */
+    total_nodes = num_nodes + 1;
+
+    if (num_threads < 2)
+        fatal_error ("Node_pool: Need at least two threads - %d\n", num_threads);
+    if (num_threads > total_nodes)
+        num_threads = total_nodes;
+
+    this->num_threads = num_threads;
+    this->phase = PHASE_EXIT;
+    this->workers = new Node_worker[num_threads];
+
+    /** Contiguous node ranges keep the merge in node order.  */
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i].pool = this;
+        workers[i].id = i;
+        workers[i].first_node = (total_nodes * i) / num_threads;
+        workers[i].last_node = (total_nodes * (i + 1)) / num_threads - 1;
+    }
+
+    pthread_barrier_init (&phase_start, NULL, num_threads);
+    pthread_barrier_init (&phase_done, NULL, num_threads);
+
+    num_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (num_cpus < 1)
+        num_cpus = 1;
+
+    /** Worker 0 is the simulator thread itself.  It stays unpinned, as do
+     *  the trace prefetch and log writer threads it started, so they share
+     *  CPU 0 and whatever the other workers leave idle.  Workers 1.. get
+     *  CPUs 1.. to themselves.  */
+    workers[0].thread = pthread_self ();
+    for (int i = 1; i < num_threads; i++)
+    {
+        if (pthread_create (&workers[i].thread, NULL, worker_main, &workers[i]))
+            fatal_error ("Node_pool: Unable to create worker %d\n", i);
+
+#ifdef __linux__
+        if (num_cpus > 1)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO (&cpus);
+            CPU_SET (1 + (i - 1) % (num_cpus - 1), &cpus);
+            pthread_setaffinity_np (workers[i].thread, sizeof (cpus), &cpus);
+        }
+#endif
+    }
+}
+
+Node_pool::~Node_pool ()
+{
+    phase = PHASE_EXIT;
+    pthread_barrier_wait (&phase_start);
+
+    for (int i = 1; i < num_threads; i++)
+        pthread_join (workers[i].thread, NULL);
+
+    pthread_barrier_destroy (&phase_start);
+    pthread_barrier_destroy (&phase_done);
+
+    delete [] workers;
+}
+
+void *Node_pool::worker_main (void *arg)
+{
+    Node_worker *worker = (Node_worker *)arg;
+    Node_pool *pool = worker->pool;
+
+    sim_worker = worker->id;
+
+    while (true)
+    {
+        pthread_barrier_wait (&pool->phase_start);
+        if (pool->phase == PHASE_EXIT)
+            break;
+
+        pool->run_nodes (worker->id);
+        pthread_barrier_wait (&pool->phase_done);
+    }
+    return NULL;
+}
+
+/** Run one phase on every node, then replay the buffered side effects.  */
+void Node_pool::run_phase (node_phase_t phase)
+{
+    assert (phase != PHASE_EXIT);
+    this->phase = phase;
+
+    pthread_barrier_wait (&phase_start);
+
+    sim_worker = 0;
+    run_nodes (0);
+    sim_worker = -1;
+
+    pthread_barrier_wait (&phase_done);
+
+    merge ();
+}
+
+void Node_pool::run_nodes (int worker)
+{
+    for (int i = workers[worker].first_node; i <= workers[worker].last_node; i++)
+    {
+        switch (phase) {
+        case PHASE_TICK_CACHE: Sim->Nd[i]->tick_cache (); break;
+        case PHASE_TICK_PR:    Sim->Nd[i]->tick_pr (); break;
+        case PHASE_TOCK_PR:    Sim->Nd[i]->tock_pr (); break;
+        default:
+            fatal_error ("Node_pool: Invalid phase - %d\n", phase);
+        }
+    }
+}
+
+void Node_pool::merge (void)
+{
+    for (int i = 0; i < num_threads; i++)
+    {
+        Node_worker *w = &workers[i];
+
+        flush_log (i);
+
+        while (!w->bus_requests.empty ())
+        {
+            Sim->bus->bus_request (w->bus_requests.front ());
+            w->bus_requests.pop_front ();
+        }
+
+        if (w->shared_line)
+        {
+            Sim->bus->set_shared_active ();
+            w->shared_line = false;
+        }
+
+        for (unsigned int j = 0; j < w->wakeups.size (); j++)
+            Sim->schedule (w->wakeups[j]);
+        w->wakeups.clear ();
+    }
+
+    Sim->merge_counters ();
+}
+
+/****************************************
+ * Worker context side effect buffering.
+ ****************************************/
+void Node_pool::append_log (int worker, const char *fmt, va_list ap)
+{
+    Node_worker *w = &workers[worker];
+    va_list aq;
+    int len;
+
+    va_copy (aq, ap);
+    len = vsnprintf (w->log_buf + w->log_len, w->log_cap - w->log_len, fmt, aq);
+    va_end (aq);
+    assert (len >= 0);
+
+    if (w->log_len + len >= w->log_cap)
+    {
+        while (w->log_len + len >= w->log_cap)
+            w->log_cap *= 2;
+        w->log_buf = (char *)realloc (w->log_buf, w->log_cap);
+        assert (w->log_buf && "Node_worker: Unable to grow log buffer.");
+
+        len = vsnprintf (w->log_buf + w->log_len, w->log_cap - w->log_len, fmt, ap);
+    }
+    w->log_len += len;
+}
+
+void Node_pool::defer_bus_request (int worker, Mreq *request)
+{
+    workers[worker].bus_requests.push_back (request);
+}
+
+void Node_pool::defer_shared_line (int worker)
+{
+    workers[worker].shared_line = true;
+}
+
+void Node_pool::defer_wakeup (int worker, timestamp_t when)
+{
+    workers[worker].wakeups.push_back (when);
+}
+
+void Node_pool::defer_event (int worker, event_record_t *rec)
+{
+    workers[worker].events.push_back (*rec);
+}
+
+/** Write out everything a worker logged so far.  */
+void Node_pool::flush_log (int worker)
+{
+    Node_worker *w = &workers[worker];
+
+    if (w->log_len)
+    {
+        sim_write (w->log_buf, w->log_len);
+        w->log_len = 0;
+    }
+
+    for (unsigned int i = 0; i < w->events.size (); i++)
+        sim_record_event (&w->events[i]);
+    w->events.clear ();
+}
@@ -0,0 +1,84 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "event_log.h"
+#include "types.h"
+
+class Node_pool;
+
+/** Index of the calling worker during a parallel phase, -1 otherwise.  */
+extern __thread int sim_worker;
+
+typedef enum {
+    PHASE_TICK_CACHE = 0,
+    PHASE_TICK_PR,
+    PHASE_TOCK_PR,
+    PHASE_EXIT
+} node_phase_t;
+
+/** Side effects a worker produced during one phase.  They are replayed in
+ *  worker order, and workers own contiguous node ranges, so the replay
+ *  happens in node order exactly as the serial loop would have done it.  */
+class Node_worker {
+public:
+    Node_worker ();
+    ~Node_worker ();
+
+    Node_pool *pool;
+    int id;
+    pthread_t thread;
+    int first_node;
+    int last_node;
+
+    char *log_buf;
+    size_t log_len;
+    size_t log_cap;
+
+    LIST<Mreq*> bus_requests;
+    bool shared_line;
+    VECTOR<timestamp_t> wakeups;
+    VECTOR<event_record_t> events;
+};
+
+/**
+ * Pool of host threads that evaluates the per-node tick phases of a cycle
+ * in parallel.  The calling thread acts as worker 0 and is left unpinned,
+ * the others are pinned to CPUs 1 and up.  Workers meet at a barrier before
+ * and after every phase, and the calling thread then merges the buffered
+ * side effects (log text and events, bus requests, the shared line, wakeups
+ * and Sim counters) so results are bit-identical to the serial run.
+ */
+class Node_pool {
+public:
+    Node_pool (int num_threads, int num_nodes);
+    ~Node_pool ();
+
+    int num_threads;
+
+    void run_phase (node_phase_t phase);
+
+    /** Called from worker context instead of touching shared state.  */
+    void append_log (int worker, const char *fmt, va_list ap);
+    void defer_bus_request (int worker, Mreq *request);
+    void defer_shared_line (int worker);
+    void defer_wakeup (int worker, timestamp_t when);
+    void defer_event (int worker, event_record_t *rec);
+
+    void flush_log (int worker);
+
+private:
+    Node_worker *workers;
+    node_phase_t phase;
+
+    pthread_barrier_t phase_start;
+    pthread_barrier_t phase_done;
+
+    static void *worker_main (void *arg);
+    void run_nodes (int worker);
+    void merge (void);
+};
+
+#endif /* NODE_POOL_H_ */
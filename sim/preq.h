@@ -0,0 +1,39 @@
+#ifndef PREQ_H_
+#define PREQ_H_
+
+#include "module.h"
+#include "types.h"
+#include "../protocols/messages.h"
+
+/**
+ * Lifetime of one processor request, from the cycle Processor::tick issues
+ * it to the cycle its DATA reaches the processor.  The L1 notes where the
+ * data came from when it arrives over the bus, and whether it went to the
+ * bus as an upgrade; a request that never needed the bus was a hit.
+ */
+class Preq {
+public:
+    Preq (ModuleID mid, paddr_t addr, message_t msg);
+    ~Preq ();
+
+    ModuleID mid;
+    paddr_t addr;
+    message_t msg;
+
+    timestamp_t req_time;
+    timestamp_t resolve_time;
+    bool resolved;
+
+    /** Module that supplied the data, INVALID_M for a hit.  */
+    module_t source;
+
+    /** Sent to the bus for a line the L1 already held.  */
+    bool upgrade;
+
+    /** Marks the request complete, returns its latency in cycles.  */
+    timestamp_t resolve (timestamp_t complete);
+
+    void dump ();
+};
+
+#endif /* PREQ_H_ */
@@ -9,21 +9,43 @@
 using namespace std;
 
 extern Simulator * Sim;
+extern Sim_settings settings;
 
 Processor::Processor (ModuleID moduleID, Hash_table *cache, char *trace_file)
     : Module (moduleID, "Processor_")
 {
     this->moduleID = moduleID;
-    this->infile = fopen (trace_file, "r");
+    this->trace = open_trace (trace_file, settings.trace_mmap);
+    if (!this->trace)
+        fatal_error ("Processor %d: Unable to open trace %s\n", moduleID.nodeID, trace_file);
+
+    /** A binary trace says which run it was converted for.  */
+    const trace_header_t *header = this->trace->bin_header ();
+    if (header)
+    {
+        if (header->line_size != settings.cache_line_size)
+            fatal_error ("Processor %d: %s was written for %u byte lines, not %u\n",
+                         moduleID.nodeID, trace_file, header->line_size, settings.cache_line_size);
+        if (header->num_cores != (uint32_t)settings.num_nodes)
+            fatal_error ("Processor %d: %s was written for %u cores, not %d\n",
+                         moduleID.nodeID, trace_file, header->num_cores, settings.num_nodes);
+        if (header->core != (uint32_t)moduleID.nodeID)
+            fatal_error ("Processor %d: %s holds the references of core %u\n",
+                         moduleID.nodeID, trace_file, header->core);
+    }
     this->my_cache = cache;
     this->end_of_trace = false;
+    this->outstanding_request = false;
     this->inbound_request = NULL;
     this->inbound_request_buf = NULL;
+    this->preq = NULL;
 }
 
 Processor::~Processor ()
 {
-    fclose (this->infile);
+    delete this->trace;
+    if (this->preq)
+        delete this->preq;
 }
 
 /** Done once at end of trace and no outstanding requests.  */
@@ -36,12 +58,19 @@ void Processor::tick ()
 {
     char c;
     paddr_t addr;
+    trace_status_t status;
 
     if (inbound_request)
     {
-    	fprintf(stderr,"* COMPLETE -- PR: %d -- Clock: %lld\n",moduleID.nodeID, Global_Clock);
+    	SIM_EVENT (LOG_VALIDATION, EV_COMPLETE, moduleID, inbound_request);
     	assert (inbound_request->msg == DATA);
     	outstanding_request = false;
+    	if (preq)
+    	{
+    		record_latency ();
+    		delete preq;
+    		preq = NULL;
+    	}
         delete inbound_request;
     }
     inbound_request = NULL;
@@ -49,11 +78,12 @@ void Processor::tick ()
     if (end_of_trace || outstanding_request)
         return;
 
-    if (fscanf (infile, "%c 0x%llx\n", &c, (unsigned long long int*)&addr) == 2)
+    status = trace->next (&c, &addr);
+    if (status == TRACE_OK)
     {
         Mreq *request;
 
-        fprintf (stderr,"* FETCH -- PR: %d -- Clock: %lld -- %c 0x%llx\n", moduleID.nodeID, Global_Clock, c, (unsigned long long int)addr);
+        SIM_EVENT (LOG_VALIDATION, EV_FETCH, moduleID, NULL, c, addr);
 
         switch (c) {
         case 'r': request = new Mreq (LOAD, addr, moduleID); break;
@@ -64,19 +94,46 @@ void Processor::tick ()
         
         my_cache->proc_request =  request;
         outstanding_request = true;
+        if (Sim->stats)
+            preq = new Preq (moduleID, request->addr, request->msg);
+
+        /** The cache picks up the request next cycle.  */
+        Sim->schedule (Global_Clock + 1);
     }
     else
     {
+        if (status == TRACE_CORRUPT)
+            fatal_error ("Processor %d: corrupt binary trace\n", moduleID.nodeID);
         end_of_trace = true;
     }
 }
 
+/** Latency from issue to DATA, by op and by who supplied the data.  */
+void Processor::record_latency ()
+{
+    latency_source_t source;
+    latency_op_t op;
+
+    switch (preq->source) {
+    case INVALID_M: source = LAT_HIT; break;
+    case MC_M:      source = LAT_MEMORY; break;
+    default:        source = LAT_C2C; break;
+    }
+    /** With or without DATA, it already had the line.  */
+    if (preq->upgrade)
+        source = LAT_UPGRADE;
+    op = (preq->msg == LOAD) ? LAT_LOAD : LAT_STORE;
+
+    Sim->stats->core (moduleID.nodeID)->latency[op][source].record (preq->resolve (Global_Clock));
+}
+
 void Processor::tock ()
 {
 	if (inbound_request_buf)
 	{
 		inbound_request = inbound_request_buf;
 		inbound_request_buf = NULL;
+		Sim->schedule (Global_Clock + 1);
 	}
 }
 
@@ -6,7 +6,9 @@
 
 #include "module.h"
 #include "mreq.h"
+#include "preq.h"
 #include "settings.h"
+#include "trace.h"
 #include "types.h"
 
 using namespace std;
@@ -18,7 +20,8 @@ public:
 	Processor(ModuleID moduleID, Hash_table *cache, char *trace_file);
 	~Processor();
 
-    FILE *infile;
+    /** Text or binary, picked from the trace file itself.  */
+    Trace_reader *trace;
     Hash_table *my_cache;
 
     bool end_of_trace;
@@ -27,10 +30,16 @@ public:
     Mreq * inbound_request;
     Mreq * inbound_request_buf;
 
+    /** Lifetime of the outstanding request, NULL unless keeping stats.  */
+    Preq *preq;
+
     bool done ();
 
 	void tick ();
 	void tock ();
+
+private:
+	void record_latency ();
 };
 
 #endif // PROCESSOR_H
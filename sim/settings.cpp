@@ -34,6 +34,17 @@ setts identifiers [] = {
     {"mem_ctrl_array",          &(settings.mem_ctrl_array)        },
 
 	{"heartrate",               &(settings.heartrate)             },
+	{"host_profile",            &(settings.host_profile)          },
+	{"sim_threads",             &(settings.sim_threads)           },
+	{"trace_mmap",              &(settings.trace_mmap)            },
+	{"trace_prefetch",          &(settings.trace_prefetch)        },
+	{"log_level",               &(settings.log_level)             },
+	{"log_file",                &(settings.log_file)              },
+	{"event_log",               &(settings.event_log)             },
+	{"event_log_size",          &(settings.event_log_size)        },
+	{"digest_file",             &(settings.digest_file)           },
+	{"digest_record",           &(settings.digest_record)         },
+	{"digest_interval",         &(settings.digest_interval)       },
 	{"net_infinite_bw",		   	&(settings.net_infinite_bw)       },
 	{"sharer_forwarding",	   	&(settings.sharer_forwarding)     },
 	{"wait_on_inv_acks",	   	&(settings.wait_on_inv_acks)      },
@@ -139,9 +150,17 @@ setts identifiers [] = {
 	{"buffer_entries_per_vc",	&(settings.buffer_entries_per_vc) },
 	{"debug_addr",	            &(settings.debug_addr)            },
     {"test_addr",               &(settings.test_addr)            },
+	{"watch_addrs",             &(settings.watch_addrs)           },
+	{"watch_depth",             &(settings.watch_depth)           },
 
 	/** report generation, tell simulator to output to cerr, cout, or null for no output **/
 	{"report_output",           &(settings.report_output)         },
+	{"report_file",             &(settings.report_file)           },
+	{"series_file",             &(settings.series_file)           },
+	{"hot_lines",               &(settings.hot_lines)             },
+	{"trace_export",            &(settings.trace_export)          },
+	{"trace_export_start",      &(settings.trace_export_start)    },
+	{"trace_export_end",        &(settings.trace_export_end)      },
 
 	/** Sampling Rate for statistics that are collected in intervals (i.e. avg sharer stat **/
 	{"sampling_interval",		&(settings.sampling_interval)	  },
@@ -184,6 +203,17 @@ void Sim_settings::print_settings (void)
 	fprintf (stderr, " wait_on_inv_acks:      %16s\n", wait_on_inv_acks == true ? "true" : "false");
 	fprintf (stderr, " livelock_check:        %16s\n", livelock_check == true ? "true" : "false");
     fprintf (stderr, " heartrate              %16d\n", heartrate);
+    fprintf (stderr, " host_profile           %16s\n", host_profile == true ? "true" : "false");
+    fprintf (stderr, " sim_threads            %16d\n", sim_threads);
+    fprintf (stderr, " trace_mmap             %16s\n", trace_mmap == true ? "true" : "false");
+    fprintf (stderr, " trace_prefetch         %16d\n", trace_prefetch);
+    fprintf (stderr, " log_level              %16d\n", log_level);
+    fprintf (stderr, " log_file               %16s\n", log_file ? log_file : "stderr");
+    fprintf (stderr, " event_log              %16s\n", event_log ? event_log : "text");
+    fprintf (stderr, " event_log_size         %16llu\n", event_log_size);
+    fprintf (stderr, " digest_file            %16s\n", digest_file ? digest_file : "none");
+    fprintf (stderr, " digest_record:         %16s\n", digest_record == true ? "true" : "false");
+    fprintf (stderr, " digest_interval        %16d\n", digest_interval);
 	fprintf (stderr, " processor_affinity:    %16s\n", processor_affinity == true ? "true" : "false");
     fprintf (stderr, " mem_model_enabled:     %16s\n", mem_model_enabled == true ? "true" : "false");
 	fprintf (stderr, " regression_test:       %16s\n", regression_test == true ? "true" : "false");
@@ -290,8 +320,17 @@ void Sim_settings::print_settings (void)
 	fprintf (stderr, " buffer_entries_per_vc: %16d\n", buffer_entries_per_vc);
 	fprintf (stderr, " debug_addr:            0x%14llx\n", (unsigned long long int) debug_addr);
     fprintf (stderr, " test_addr:             0x%14llx\n", (unsigned long long int) test_addr);
+	fprintf (stderr, " watch_addrs:           %16s\n", watch_addrs ? watch_addrs : "none");
+	fprintf (stderr, " watch_depth:           %16d\n", watch_depth);
 
 	fprintf (stderr, " sampling_interval:     %lld\n", sampling_interval);
+	fprintf (stderr, " report_output:         %16d\n", report_output);
+	fprintf (stderr, " report_file:           %16s\n", report_file ? report_file : "none");
+	fprintf (stderr, " series_file:           %16s\n", series_file ? series_file : "none");
+	fprintf (stderr, " hot_lines:             %16d\n", hot_lines);
+	fprintf (stderr, " trace_export:          %16s\n", trace_export ? trace_export : "none");
+	fprintf (stderr, " trace_export_window:   %llu-%llu\n", (unsigned long long)trace_export_start,
+	         (unsigned long long)trace_export_end);
 }
 
 void Sim_settings::set_defaults (void)
@@ -315,6 +354,17 @@ void Sim_settings::set_defaults (void)
     mem_ctrl_array[3]       = 36;
 
     heartrate               = (1 << 16);
+    host_profile            = false;
+    sim_threads             = 1;
+    trace_mmap              = false;
+    trace_prefetch          = 0;
+    log_level               = LOG_VALIDATION;
+    log_file                = NULL;
+    event_log               = NULL;
+    event_log_size          = (1 << 20);
+    digest_file             = NULL;
+    digest_record           = false;
+    digest_interval         = DIGEST_INTERVAL;
     net_infinite_bw			= false;
     sharer_forwarding		= true;
     wait_on_inv_acks	    = true;
@@ -353,7 +403,7 @@ void Sim_settings::set_defaults (void)
     l1_coherence_policy		= MESI;
     l1_cache_policy			= CACHE_PRIVATE;
     l1_lookup_time			= 3;
-    l1_infinite             = false;
+    l1_infinite             = true;
     
     l2_cache_type           = CACHE_DATA;
     l2_cache_size           = 65536;
@@ -410,10 +460,18 @@ void Sim_settings::set_defaults (void)
 
     debug_addr              = 0x0;
     test_addr               = 0x0;
+    watch_addrs             = NULL;
+    watch_depth             = 32;
 
 	data_graph = false;
 
     report_output           = OUTPUT_FMT_CSV;
+    report_file             = NULL;
+    series_file             = NULL;
+    hot_lines               = 0;
+    trace_export            = NULL;
+    trace_export_start      = 0;
+    trace_export_end        = ~(timestamp_t)0;
 
     trace_dir               = NULL;
 }
@@ -27,6 +27,32 @@ public:
     int*                 mem_ctrl_array;
 
     unsigned int         heartrate;
+    /** Heartbeat every heartrate cycles and host time per phase at the end.  */
+    bool                 host_profile;
+
+    /** Host threads evaluating nodes, 1 runs serially.  */
+    int                  sim_threads;
+
+    /** Parse text traces from an mmap instead of stdio.  */
+    bool                 trace_mmap;
+
+    /** Background trace decoder threads, 0 decodes inside Processor::tick.  */
+    int                  trace_prefetch;
+
+    /** Event log verbosity, a log_level_t.  */
+    int                  log_level;
+
+    /** Send simulator output here instead of stderr, NULL for stderr.  */
+    char                 *log_file;
+
+    /** Binary event ring file and its size in records, NULL for text.  */
+    char                 *event_log;
+    unsigned long long   event_log_size;
+
+    /** Event digest file, recorded or checked against, NULL when off.  */
+    char                 *digest_file;
+    bool                 digest_record;
+    int                  digest_interval;
 
 	bool 				 net_infinite_bw;
 	bool 				 sharer_forwarding;
@@ -142,9 +168,28 @@ public:
 
 	sim_output_mode_t    report_output;
 
+    /** Structured stats report, written as report_output says, NULL when off.  */
+    char                 *report_file;
+
+    /** Time series of the stats every sampling_interval cycles, NULL when off.  */
+    char                 *series_file;
+
+    /** Contended lines reported at the end of the run, 0 when off.  */
+    int                  hot_lines;
+
+    /** Chrome trace of bus and memory transactions in a cycle window, NULL when off.  */
+    char                 *trace_export;
+    timestamp_t          trace_export_start;
+    timestamp_t          trace_export_end;
+
 	paddr_t              debug_addr;
     paddr_t              test_addr;
 
+    /** Lines whose last watch_depth bus events are kept, besides debug_addr
+     *  and test_addr when set: comma separated addresses, NULL when none.  */
+    char                 *watch_addrs;
+    int                  watch_depth;
+
     char                 *trace_dir;
 
     protocol_t protocol;
@@ -190,5 +235,7 @@ public:
 #define ABS(a)		    ((a) < 0 ? (0 - (a)) : (a))
 #define ISPOW2(a)       (((a) & ((a) - 1)) ? 0 : 1)
 
+extern Sim_settings settings;
+
 #endif
 
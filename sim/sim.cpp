@@ -1,6 +1,9 @@
 #include <math.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 
 #include "hash_table.h"
@@ -13,6 +16,11 @@
 #include "types.h"
 
 extern Sim_settings settings;
+extern Simulator *Sim;
+
+/** This must match what's in enums.h.  */
+const char *protocol_str[MEM_PRO + 1] = {"CACHE_PRO","MI_PRO","MSI_PRO","MESI_PRO",
+                                         "MOESI_PRO","MOSI_PRO","MOESIF_PRO","NULL_PRO","MEM_PRO"};
 
 /** Fatal Error.  */
 void fatal_error (const char *fmt, ...)
@@ -23,11 +31,131 @@ void fatal_error (const char *fmt, ...)
     vfprintf (stderr, fmt, ap);
     va_end (ap);
     
+    /** What led up to it on the watched lines.  */
+    if (Sim && Sim->ref_stream)
+        Sim->ref_stream->dump ();
+
+    /** Don't lose what the failing worker printed before dying.  */
+    if (sim_worker >= 0)
+        Sim->pool->flush_log (sim_worker);
+    if (Sim && Sim->log)
+        Sim->log->flush ();
+
     /** Enable debugging by asserting zero.  */
     assert (0 && "Fatal Error");
     exit (-1);
 }
 
+/** SIGUSR1 asks for the watched lines' events, dumped between cycles.  */
+static volatile sig_atomic_t ref_stream_requested = 0;
+
+static void ref_stream_signal (int signum)
+{
+    ref_stream_requested = 1;
+}
+
+/** Printf for the simulator hot path.  Output produced during a parallel
+ *  phase is buffered per worker and emitted in node order.  */
+void sim_printf (const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start (ap, fmt);
+    if (sim_worker >= 0)
+        Sim->pool->append_log (sim_worker, fmt, ap);
+    else if (Sim && Sim->log)
+        Sim->log->vprintf (fmt, ap);
+    else
+        vfprintf (stderr, fmt, ap);
+    va_end (ap);
+}
+
+/** Unformatted output, always from the simulator thread.  */
+void sim_write (const char *buf, size_t len)
+{
+    if (Sim && Sim->log)
+        Sim->log->write (buf, len);
+    else
+        fwrite (buf, 1, len, stderr);
+}
+
+void sim_event (event_kind_t kind, ModuleID node, Mreq *request, char op, paddr_t addr)
+{
+    event_record_t rec;
+    char line[EVENT_LOG_MAX_LINE];
+
+    memset (&rec, 0, sizeof (rec));
+    rec.clock = Global_Clock;
+    rec.kind = kind;
+    rec.node = node.nodeID;
+    rec.module = node.module_index;
+    rec.op = op;
+    rec.addr = addr;
+    rec.src_node = -1;
+    rec.src_module = INVALID_M;
+    rec.dest_node = -1;
+    rec.dest_module = INVALID_M;
+    rec.msg = MREQ_INVALID;
+
+    if (request)
+    {
+        rec.addr = request->addr;
+        rec.src_node = request->src_mid.nodeID;
+        rec.src_module = request->src_mid.module_index;
+        rec.dest_node = request->dest_mid.nodeID;
+        rec.dest_module = request->dest_mid.module_index;
+        rec.msg = request->msg;
+    }
+
+    if (Sim->event_log || Sim->digest)
+    {
+        if (sim_worker >= 0)
+            Sim->pool->defer_event (sim_worker, &rec);
+        else
+            sim_record_event (&rec);
+        return;
+    }
+
+    event_render (&rec, settings.cache_line_size_log2, Mreq::message_t_str[rec.msg],
+                  line, sizeof (line));
+    sim_printf ("%s", line);
+}
+
+/** Events that are not printed, in simulation order.  */
+void sim_record_event (const event_record_t *rec)
+{
+    if (Sim->digest)
+        Sim->digest->add (rec);
+    if (Sim->event_log)
+        Sim->event_log->append (rec);
+}
+
+/***************************************************************************
+ * Sim_counter constructor, destructor, and functions.
+ ***************************************************************************/
+Sim_counter::Sim_counter ()
+{
+    total = 0;
+    partial = new counter_t[settings.sim_threads * SIM_COUNTER_STRIDE]();
+}
+
+Sim_counter::~Sim_counter ()
+{
+    delete [] partial;
+}
+
+void Sim_counter::merge (int num_workers)
+{
+    for (int i = 0; i < num_workers; i++)
+    {
+        total += partial[i * SIM_COUNTER_STRIDE];
+        partial[i * SIM_COUNTER_STRIDE] = 0;
+    }
+}
+
+/***************************************************************************
+ * Simulator constructor, destructor, and functions.
+ ***************************************************************************/
 Simulator::Simulator ()
 {
     /** Seed random number generator.  */
@@ -36,10 +164,74 @@ Simulator::Simulator ()
     /** Set global_clock to cycle zero.  */
     global_clock = 0;
 
+    /** Everything the run prints goes to log_file when one is given.  */
+    log = NULL;
+    if (settings.log_file)
+        log = new Log_sink (settings.log_file);
+
+    /** Events go to a binary ring instead of the text log.  */
+    event_log = NULL;
+    if (settings.event_log)
+    {
+        event_log = new Event_log ();
+        if (!event_log->open (settings.event_log, settings.event_log_size,
+                              settings.cache_line_size_log2,
+                              Mreq::message_t_str, MREQ_MESSAGE_NUM))
+            fatal_error ("Sim error: Unable to create event log %s\n", settings.event_log);
+    }
+
+    /** Digest validation hashes events instead of printing them, so it
+     *  needs the validation events generated in the first place.  */
+    digest = NULL;
+    if (settings.digest_file && !sim_log_enabled (LOG_VALIDATION))
+        fatal_error ("Sim error: A digest hashes the validation events, which %s\n",
+                     SIM_LOG_MAX < LOG_VALIDATION ? "this build compiles out (SIM_LOG_MAX)"
+                                                  : "log level quiet turns off");
+    if (settings.digest_file)
+        digest = new Event_digest (settings.digest_file, settings.digest_record,
+                                   settings.digest_interval, settings.cache_line_size_log2,
+                                   Mreq::message_t_str);
+
+    /** Per core, state and message counters, only kept for a report or
+     *  the time series.  */
+    stats = NULL;
+    if ((settings.report_file && settings.report_output != OUTPUT_FMT_NONE) ||
+        settings.series_file)
+        stats = new Stats_registry (settings.num_nodes);
+
+    series = NULL;
+    if (settings.series_file)
+        series = new Stats_series (settings.series_file, settings.sampling_interval);
+
+    trace_export = NULL;
+    if (settings.trace_export)
+        trace_export = new Trace_export (settings.trace_export, settings.trace_export_start,
+                                         settings.trace_export_end);
+
+    sharing = NULL;
+    if (settings.sim_analysis_enabled)
+        sharing = new Sharing_tracker (settings.ro_tracker_gran, settings.ro_tracker_entries);
+
+    contention = NULL;
+    if (settings.hot_lines > 0)
+        contention = new Contended_line_tracker (settings.hot_lines);
+
+    ref_stream = NULL;
+    profile = NULL;
+
     /** Allocate bus.  */
     bus = new Bus ();
     assert (bus && "Sim error: Unable to alloc bus.");
 
+    /** Allocate message pool, one freelist per host thread.  */
+    mreq_pool = new Mreq_pool (settings.sim_threads);
+
+    /** Allocate line table, only infinite L1s keep their lines in it.  */
+    lines = settings.l1_infinite ? new Line_table () : NULL;
+
+    /** Allocate event wheel.  */
+    events = new Event_wheel (EVENT_WHEEL_SLOTS);
+
     Nd = new Node*[settings.num_nodes+1];
 
     /** Allocate processors.  */
@@ -52,22 +244,85 @@ Simulator::Simulator ()
         Nd[node]->build_processor (trace_file);
     }
 
+    /** Swap every processor's reader for a ring its decoder thread fills.  */
+    prefetch = NULL;
+    if (settings.trace_prefetch > 0)
+    {
+        prefetch = new Trace_prefetcher (settings.trace_prefetch);
+        for (int node = 0; node < settings.num_nodes; node++)
+            get_PR (node)->trace = prefetch->attach (get_PR (node)->trace);
+        prefetch->start ();
+    }
+
     /** Allocate memory controllers.  */
     Nd[settings.num_nodes] = new Node (settings.num_nodes);
     Nd[settings.num_nodes]->build_memory_controller ();
 
-    cache_misses = 0;
-    silent_upgrades = 0;
-    cache_to_cache_transfers = 0;
-    cache_accesses = 0;
+    /** Start node workers last, they tick what was built above.  */
+    pool = NULL;
+    if (settings.sim_threads > 1)
+        pool = new Node_pool (settings.sim_threads, settings.num_nodes);
+
+    /** Watched lines, once the caches they read states from exist.  */
+    if (settings.debug_addr || settings.test_addr || settings.watch_addrs)
+    {
+        ref_stream = new Reference_stream_tracker (settings.watch_depth);
+        if (settings.debug_addr)
+            ref_stream->watch (settings.debug_addr);
+        if (settings.test_addr)
+            ref_stream->watch (settings.test_addr);
+        for (const char *p = settings.watch_addrs; p && *p; )
+        {
+            char *end;
+            paddr_t addr = strtoull (p, &end, 0);
+
+            if (end == p || (*end && *end != ','))
+                fatal_error ("Sim error: invalid watch address - %s\n", p);
+            ref_stream->watch (addr);
+            p = *end ? end + 1 : end;
+        }
+        signal (SIGUSR1, ref_stream_signal);
+    }
 }
 
 Simulator::~Simulator ()
 {
+    if (pool)
+        delete pool;
+
+    /** Decoders still read the processors' traces.  */
+    if (prefetch)
+        delete prefetch;
+
     for (int i = 0; i < settings.num_nodes; i++)
         delete Nd[i];
 
     delete [] Nd;    
+    delete events;
+    delete lines;
+    delete bus;
+    delete mreq_pool;
+
+    if (log)
+        delete log;
+    if (event_log)
+        delete event_log;
+    if (digest)
+        delete digest;
+    if (series)
+        delete series;
+    if (trace_export)
+        delete trace_export;
+    if (contention)
+        delete contention;
+    if (sharing)
+        delete sharing;
+    if (ref_stream)
+        delete ref_stream;
+    if (profile)
+        delete profile;
+    if (stats)
+        delete stats;
 }
 
 void Simulator::dump_stats ()
@@ -76,44 +331,77 @@ void Simulator::dump_stats ()
     {
     	get_L1(i)->dump_hash_table();
     }
-    fprintf(stderr,"\nRun Time:         %8lld cycles\n",global_clock);
-    fprintf(stderr,"Cache Misses:     %8ld misses\n",cache_misses);
-    fprintf(stderr,"Cache Accesses:   %8ld accesses\n",cache_accesses);
-    fprintf(stderr,"Silent Upgrades:  %8ld upgrades\n",silent_upgrades);
-    fprintf(stderr,"$-to-$ Transfers: %8ld transfers\n",cache_to_cache_transfers);
+    sim_printf("\nRun Time:         %8lld cycles\n",global_clock);
+    sim_printf("Cache Misses:     %8ld misses\n",(unsigned long)cache_misses.value ());
+    sim_printf("Cache Accesses:   %8ld accesses\n",(unsigned long)cache_accesses.value ());
+    sim_printf("Silent Upgrades:  %8ld upgrades\n",(unsigned long)silent_upgrades.value ());
+    sim_printf("$-to-$ Transfers: %8ld transfers\n",(unsigned long)cache_to_cache_transfers.value ());
+    if (!settings.l1_infinite)
+        sim_printf("Writebacks:       %8ld writebacks\n",(unsigned long)writebacks.value ());
+
+    /** The bus still owns the message of the final cycle.  */
+    counter_t leaks = mreq_pool->get_live () - (bus->current_request ? 1 : 0);
+    if (leaks)
+        sim_printf("Mreq Leaks:       %8ld messages of %ld pooled\n",(unsigned long)leaks,
+                   (unsigned long)mreq_pool->get_pooled ());
+}
+
+void Simulator::merge_counters (void)
+{
+    cache_misses.merge (pool->num_threads);
+    cache_accesses.merge (pool->num_threads);
+    silent_upgrades.merge (pool->num_threads);
+    cache_to_cache_transfers.merge (pool->num_threads);
+    writebacks.merge (pool->num_threads);
+}
+
+/** Request a tick of every module at cycle when.  */
+void Simulator::schedule (timestamp_t when)
+{
+    if (sim_worker >= 0)
+        pool->defer_wakeup (sim_worker, when);
+    else
+        events->schedule (when);
 }
 
 void Simulator::run ()
 {
-    int sched;
     bool done;
 
-    /** This must match what's in enums.h.  */
-    const char *cp_str[9] = {"CACHE_PRO","MI_PRO","MSI_PRO","MESI_PRO",
-							 "MOESI_PRO","MOSI_PRO","MOESIF_PRO","NULL_PRO","MEM_PRO"};
+    sim_printf ("CSX290 Sim - Begins  ");
+    sim_printf (" Cores: %d", settings.num_nodes);
+    sim_printf (" Protocol: %s\n", protocol_str[settings.protocol]);
+
+    /** Every processor fetches its first reference on cycle zero.  */
+    schedule (global_clock);
 
-    fprintf (stderr, "CSX290 Sim - Begins  ");
-    fprintf (stderr, " Cores: %d", settings.num_nodes);
-    fprintf (stderr, " Protocol: %s\n", cp_str[settings.protocol]);
+    if (settings.host_profile)
+        profile = new Host_profile (settings.heartrate);
 
-    /** Main run loop.  */
-    sched = 0;
+    /** Main run loop.  Cycles nobody scheduled are idle (everyone is
+     *  waiting on the bus or a memory controller) and are skipped.  */
     done = false;
     while (!done)
     {
-        bus->tick ();
+        if (!events->next_event (&global_clock))
+            fatal_error ("Sim error: no pending events at cycle %llu, simulation is deadlocked\n",
+                         (unsigned long long)global_clock);
 
-        for (int i = 0; i <= settings.num_nodes; i++)
-            Nd[i]->tick_cache ();
+        /** Rows for the intervals that ended while idle or last cycle.  */
+        if (series)
+            series->advance (global_clock);
 
-        for (int i = 0; i <= settings.num_nodes; i++)
-            Nd[i]->tick_pr ();
+        run_cycle ();
 
-        for (int i = 0; i <= settings.num_nodes; i++)
-            Nd[i]->tick_mc ();
-        
-        for (int i = 0; i <= settings.num_nodes; i++)
-			Nd[i]->tock_pr ();
+        if (profile)
+            profile->heartbeat (global_clock);
+        if (ref_stream_requested && ref_stream)
+        {
+            ref_stream_requested = 0;
+            ref_stream->dump ();
+            if (log)
+                log->flush ();
+        }
 
         global_clock++;
 
@@ -126,8 +414,96 @@ void Simulator::run ()
             }
     }
 
-    fprintf(stderr,"\n\nSimulation Finished\n");
+    host_mark (HOST_LOOP);
+    sim_printf("\n\nSimulation Finished\n");
     dump_stats();
+    if (contention)
+        contention->dump ();
+    if (sharing)
+        sharing->dump ();
+    if (ref_stream)
+        ref_stream->dump ();
+    if (profile)
+        profile->dump (global_clock);
+
+    /** Dashboards read the structured report instead of the text above.  */
+    if (stats && settings.report_file)
+        stats->report (settings.report_file, settings.report_output);
+    if (series)
+    {
+        series->finish (global_clock);
+        delete series;
+        series = NULL;
+    }
+    if (trace_export)
+    {
+        delete trace_export;
+        trace_export = NULL;
+    }
+
+    /** The report is the last output, closing also ends a gzip stream.  */
+    if (log)
+    {
+        delete log;
+        log = NULL;
+    }
+    if (event_log)
+    {
+        delete event_log;
+        event_log = NULL;
+    }
+
+    /** Regression scripts see a mismatch in the exit status.  */
+    if (digest)
+    {
+        bool match = digest->finish ();
+
+        delete digest;
+        digest = NULL;
+        if (!match)
+            exit (1);
+    }
+}
+
+/** Simulate a single cycle of every module.  */
+void Simulator::run_cycle ()
+{
+    host_mark (HOST_LOOP);
+    bus->tick ();
+    host_mark (HOST_BUS);
+
+    /** Only one node has a memory controller, so tick_mc stays serial.  */
+    if (pool)
+    {
+        pool->run_phase (PHASE_TICK_CACHE);
+        host_mark (HOST_CACHE);
+        pool->run_phase (PHASE_TICK_PR);
+        host_mark (HOST_PR);
+
+        for (int i = 0; i <= settings.num_nodes; i++)
+            Nd[i]->tick_mc ();
+        host_mark (HOST_MC);
+
+        pool->run_phase (PHASE_TOCK_PR);
+        host_mark (HOST_TOCK);
+        return;
+    }
+
+    for (int i = 0; i <= settings.num_nodes; i++)
+        Nd[i]->tick_cache ();
+    host_mark (HOST_CACHE);
+
+    for (int i = 0; i <= settings.num_nodes; i++)
+        Nd[i]->tick_pr ();
+    host_mark (HOST_PR);
+
+    for (int i = 0; i <= settings.num_nodes; i++)
+        Nd[i]->tick_mc ();
+    host_mark (HOST_MC);
+    
+    for (int i = 0; i <= settings.num_nodes; i++)
+		Nd[i]->tock_pr ();
+    host_mark (HOST_TOCK);
 }
 
 Processor* Simulator::get_PR (int node)
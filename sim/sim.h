@@ -3,8 +3,20 @@
 
 #include "bus.h"
 #include "enums.h"
+#include "digest.h"
+#include "event_log.h"
+#include "event_wheel.h"
+#include "host_profile.h"
+#include "line_table.h"
+#include "log_sink.h"
+#include "mreq.h"
+#include "node_pool.h"
 #include "node.h"
 #include "settings.h"
+#include "sim_analysis.h"
+#include "stats.h"
+#include "trace_export.h"
+#include "trace_prefetch.h"
 #include "types.h"
 
 #define Global_Clock Sim->global_clock
@@ -16,6 +28,66 @@ class L1_cache;
 class Memory_controller;
 
 void fatal_error (const char *fmt, ...) __attribute__ ((noreturn));
+void sim_printf (const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
+void sim_write (const char *buf, size_t len);
+
+/** Protocol names, indexed by protocol_t.  */
+extern const char *protocol_str[MEM_PRO + 1];
+
+/** Highest log level compiled in.  Building with -DSIM_LOG_MAX=0 removes
+ *  every event log call, leaving only the end of run report.  */
+#ifndef SIM_LOG_MAX
+#define SIM_LOG_MAX             LOG_DEBUG
+#endif
+
+#define sim_log_enabled(level)  ((level) <= SIM_LOG_MAX && (level) <= settings.log_level)
+
+#define SIM_LOG(level, ...)                                             \
+    do {                                                                \
+        if (sim_log_enabled (level))                                    \
+            sim_printf (__VA_ARGS__);                                   \
+    } while (0)
+
+/** Per-event log lines.  Printed as text, or appended to event_log as a
+ *  binary record that simlog renders back into the same text.  */
+void sim_event (event_kind_t kind, ModuleID node, Mreq *request,
+                char op = 0, paddr_t addr = 0);
+void sim_record_event (const event_record_t *rec);
+
+#define SIM_EVENT(level, ...)                                           \
+    do {                                                                \
+        if (sim_log_enabled (level))                                    \
+            sim_event (__VA_ARGS__);                                    \
+    } while (0)
+
+/** Cache line sized stride between the per-worker slots of a counter.  */
+#define SIM_COUNTER_STRIDE      8
+
+/**
+ * Statistic counter that parallel node workers can bump without sharing a
+ * cache line.  Each worker increments its own slot and merge () folds the
+ * slots into the total at the end of every phase.
+ */
+class Sim_counter {
+public:
+    Sim_counter ();
+    ~Sim_counter ();
+
+    void operator++ (int)
+    {
+        if (sim_worker < 0)
+            total++;
+        else
+            partial[sim_worker * SIM_COUNTER_STRIDE]++;
+    }
+
+    counter_t value (void) { return total; }
+    void merge (int num_workers);
+
+private:
+    counter_t total;
+    counter_t *partial;
+};
 
 class Simulator {
 public:
@@ -27,8 +99,61 @@ public:
     Node **Nd;
     Bus *bus;
 
+    /** Every line's state in every infinite L1, NULL with finite L1s.  */
+    Line_table *lines;
+
+    /** All Mreqs come from here.  */
+    Mreq_pool *mreq_pool;
+
+    /** Binary event ring, NULL when events are printed as text.  */
+    Event_log *event_log;
+
+    /** Event stream hash for digest validation, NULL when off.  */
+    Event_digest *digest;
+
+    /** Writer thread for log_file, NULL when printing to stderr.  */
+    Log_sink *log;
+
+    /** Structured statistics for report_file, NULL when not reporting.  */
+    Stats_registry *stats;
+
+    /** Rows of stats every sampling_interval cycles, NULL when off.  */
+    Stats_series *series;
+
+    /** Chrome trace of the bus and memory, NULL when off.  */
+    Trace_export *trace_export;
+
+    /** Sharing pattern classes of the bus traffic, NULL unless
+     *  sim_analysis_enabled.  */
+    Sharing_tracker *sharing;
+
+    /** Bus events of the watched lines, NULL when none are.  */
+    Reference_stream_tracker *ref_stream;
+
+    /** Heartbeat and host time per phase, NULL when off.  */
+    Host_profile *profile;
+    void host_mark (host_phase_t phase)
+    {
+        if (profile)
+            profile->mark (phase);
+    }
+
+    /** Top contended lines, NULL when off.  */
+    Contended_line_tracker *contention;
+
+    /** Decoder threads feeding the processors, NULL when disabled.  */
+    Trace_prefetcher *prefetch;
+
+    /** Pending module wakeups.  run () only simulates cycles in here.  */
+    Event_wheel *events;
+    void schedule (timestamp_t when);
+
+    /** Parallel node evaluation, NULL when running serially.  */
+    Node_pool *pool;
+
     /** Run/Fini for simulator.  */
     void run (void);
+    void run_cycle (void);
     void dump_stats (void);
 
     /** Accessor functions */
@@ -41,10 +166,13 @@ public:
 	void dump_outstanding_requests (int nodeID);
     void dump_cache_block (int nodeID, paddr_t addr);
 
-    unsigned long int cache_misses;
-    unsigned long int cache_accesses;
-    unsigned long int silent_upgrades;
-    unsigned long int cache_to_cache_transfers;
+    Sim_counter cache_misses;
+    Sim_counter cache_accesses;
+    Sim_counter silent_upgrades;
+    Sim_counter cache_to_cache_transfers;
+    Sim_counter writebacks;
+
+    void merge_counters (void);
 };
 
 #endif
@@ -1,141 +1,501 @@
+#include <string.h>
+
+#include "hash_table.h"
 #include "mreq.h"
+#include "settings.h"
 #include "sim.h"
 #include "sim_analysis.h"
 
-extern Simulator Sim;
+extern Sim_settings settings;
+extern Simulator *Sim;
 
 /********************************************************************************
  * Reference stream tracker.  
  ********************************************************************************/
-Ref_stream_entry::Ref_stream_entry (message_t msg, paddr_t addr, ModuleID mid)
+Reference_stream_tracker::Reference_stream_tracker (int depth)
 {
-    this->msg = msg;
-    this->addr = addr;
-    this->mid = mid;
+    assert (depth > 0);
+
+    this->depth = depth;
+    this->pending = -1;
 }
 
-Ref_stream_entry::~Ref_stream_entry ()
+Reference_stream_tracker::~Reference_stream_tracker ()
 {
+    for (unsigned int i = 0; i < streams.size (); i++)
+    {
+        delete [] streams[i].ring;
+        delete [] streams[i].states;
+    }
 }
 
-Reference_stream_tracker::Reference_stream_tracker (paddr_t ref_stream_addr, int ref_stream_max)
+void Reference_stream_tracker::watch (paddr_t addr)
 {
-    this->ref_stream_addr = ref_stream_addr;
-    this->ref_stream_max = ref_stream_max;
-    ref_stream.clear ();
+    ref_stream_t stream;
+
+    addr &= ~((paddr_t)settings.cache_line_size - 1);
+    if (index.find (addr) != index.end ())
+        return;
+
+    stream.addr = addr;
+    stream.events = 0;
+    stream.ring = new ref_stream_entry_t[depth]();
+    stream.states = new uint8_t[depth * settings.num_nodes];
+    memset (stream.states, REF_STREAM_UNSETTLED, depth * settings.num_nodes);
+
+    index[addr] = streams.size ();
+    streams.push_back (stream);
 }
 
-Reference_stream_tracker::~Reference_stream_tracker ()
+/** Reads the caches' states of the line of the previous bus event.  */
+void Reference_stream_tracker::settle (void)
 {
+    if (pending < 0)
+        return;
+
+    ref_stream_t *stream = &streams[pending];
+    uint8_t *states = &stream->states[((stream->events - 1) % depth) * settings.num_nodes];
+
+    for (int i = 0; i < settings.num_nodes; i++)
+    {
+        int state = Sim->get_L1 (i)->line_state (stream->addr);
+        states[i] = state < 0 ? REF_STREAM_NO_LINE : state;
+    }
+    pending = -1;
 }
 
-void Reference_stream_tracker::update (Mreq *request)
+void Reference_stream_tracker::bus_event (Mreq *request)
 {
-    if (ref_stream.size () >= ref_stream_max)
+    HASH_MAP<paddr_t, int>::iterator it;
+
+    it = index.find (request->addr);
+    if (it == index.end ())
         return;
 
-    ref_stream.push_back (new Ref_stream_entry (request->msg, request->addr, request->src_mid));
+    ref_stream_t *stream = &streams[it->second];
+    int slot = stream->events % depth;
+    ref_stream_entry_t *entry = &stream->ring[slot];
+
+    entry->clock = Global_Clock;
+    entry->node = request->src_mid.nodeID;
+    entry->peer = request->dest_mid.nodeID;
+    entry->msg = request->msg;
+    memset (&stream->states[slot * settings.num_nodes], REF_STREAM_UNSETTLED, settings.num_nodes);
+    stream->events++;
+    pending = it->second;
 }
 
-void Reference_stream_tracker::dump ()
+void Reference_stream_tracker::dump (void)
 {
-    LIST<Ref_stream_entry*>::iterator it;
+    const char **names = Sim->get_L1 (0)->state_names ();
+    int num_names = 0;
 
-    fprintf (stderr, "Reference Stream Tracker:\n");
-    fprintf (stderr, "Addr: 0x%llx\n", (unsigned long long)ref_stream_addr);
+    if (sim_worker < 0)
+        settle ();
+    while (names[num_names])
+        num_names++;
 
-    for (it = ref_stream.begin (); it != ref_stream.end (); it++)
+    for (unsigned int i = 0; i < streams.size (); i++)
     {
-        //fprintf (stderr, "Msg: %s Node: %d", Mreq::message_t_str[it->second->msg], it->second->mid.NodeID);
+        ref_stream_t *stream = &streams[i];
+        counter_t first = stream->events > (counter_t)depth ? stream->events - depth : 0;
+
+        sim_printf ("\nReference Stream: 0x%llx, last %llu of %llu bus events\n",
+                 (unsigned long long)stream->addr, (unsigned long long)(stream->events - first),
+                 (unsigned long long)stream->events);
+        sim_printf ("  %-12s %5s %5s %-6s %s\n", "Cycle", "Node", "Dest", "Msg", "States");
+
+        for (counter_t e = first; e < stream->events; e++)
+        {
+            ref_stream_entry_t *entry = &stream->ring[e % depth];
+            uint8_t *states = &stream->states[(e % depth) * settings.num_nodes];
+            bool cached = false;
+
+            sim_printf ("  %-12llu %5d %5d %-6s", (unsigned long long)entry->clock,
+                     entry->node, entry->peer, Mreq::message_t_str[entry->msg]);
+            for (int n = 0; n < settings.num_nodes; n++)
+            {
+                if (states[n] == REF_STREAM_NO_LINE ||
+                    (states[n] < num_names && !strcmp (names[states[n]], "I")))
+                    continue;
+                cached = true;
+                if (states[n] == REF_STREAM_UNSETTLED)
+                {
+                    sim_printf (" ?");
+                    break;
+                }
+                sim_printf (" %d:%s", n, states[n] < num_names ? names[states[n]] : "??");
+            }
+            sim_printf ("%s\n", cached ? "" : " -");
+        }
     }
 }
 
 /********************************************************************************
- * Read-only data tracker.  
+ * Sharing pattern tracker.  
  ********************************************************************************/
-Read_only_tracker::Read_only_tracker (int granularity, int max_entries)
+const char *sharing_class_str[SHARING_NUM_CLASSES] = {"private", "read-only shared", "migratory",
+                                                      "producer-consumer", "write-shared", "untracked"};
+
+Sharing_tracker::Sharing_tracker (int granularity, int max_entries)
 {
-    assert ((unsigned int)granularity >= Sim.settings.cache_line_size);
+    assert ((unsigned int)granularity >= settings.cache_line_size);
+    assert (ISPOW2 (granularity));
     assert (max_entries > 0);
 
-    /** Calculate granularity mask.  */
-    this->addr_mask = ~0x0;
-    for ( ;granularity > 1; granularity /= 2)
-        this->addr_mask <<= 1;
-
+    this->granularity = granularity;
+    this->addr_mask = ~((paddr_t)granularity - 1);
     this->max_entries = max_entries;
-    this->read_only_map.clear ();
+    this->regions.reserve (max_entries);
+    this->untracked_messages = 0;
+    this->untracked_cycles = 0;
+}
+
+Sharing_tracker::~Sharing_tracker ()
+{
+    this->regions.clear ();
+}
+
+/** The region holding addr, NULL once the table is full.  */
+sharing_region_t *Sharing_tracker::get (paddr_t addr)
+{
+    HASH_MAP<paddr_t, sharing_region_t>::iterator it;
+
+    addr &= addr_mask;
+    it = regions.find (addr);
+    if (it != regions.end ())
+        return &it->second;
+
+    if (regions.size () >= max_entries)
+        return NULL;
+
+    sharing_region_t *region = &regions[addr];
+    memset (region, 0, sizeof (*region));
+    region->last_node = -1;
+    region->last_writer = -1;
+    region->last_msg = MREQ_INVALID;
+    return region;
+}
+
+void Sharing_tracker::bus_grant (Mreq *request)
+{
+    sharing_region_t *region = get (request->addr);
+    int node = request->src_mid.nodeID;
+    uint64_t bit = (uint64_t)1 << (node & 63);
+
+    if (!region)
+    {
+        untracked_messages++;
+        if (request->msg == DATA)
+            untracked_cycles++;
+        return;
+    }
+
+    region->messages++;
+    switch (request->msg) {
+    case GETS:
+        region->readers[node >> 6] |= bit;
+        break;
+    case GETM:
+        region->getm++;
+        if (region->last_node == node && region->last_msg == GETS &&
+            region->last_writer >= 0 && region->last_writer != node)
+            region->handoffs++;
+        region->writers[node >> 6] |= bit;
+        region->last_writer = node;
+        break;
+    case DATA:
+        /** Writeback, done in this one bus cycle.  */
+        region->cycles++;
+        return;
+    default:
+        return;
+    }
+    region->last_node = node;
+    region->last_msg = request->msg;
+}
+
+void Sharing_tracker::bus_reply (Mreq *reply, timestamp_t cycles)
+{
+    sharing_region_t *region = get (reply->addr);
+
+    if (!region)
+    {
+        untracked_messages++;
+        untracked_cycles += cycles;
+        return;
+    }
+
+    region->messages++;
+    region->cycles += cycles;
+}
+
+sharing_class_t Sharing_tracker::classify (sharing_region_t *region)
+{
+    int nodes = 0, writers = 0;
+
+    for (int i = 0; i < LINE_PRESENCE_WORDS; i++)
+    {
+        nodes += __builtin_popcountll (region->readers[i] | region->writers[i]);
+        writers += __builtin_popcountll (region->writers[i]);
+    }
+
+    if (nodes <= 1)
+        return SHARING_PRIVATE;
+    if (!writers)
+        return SHARING_READ_ONLY;
+    if (writers == 1)
+        return SHARING_PRODUCER_CONSUMER;
+    if (2 * region->handoffs >= region->getm)
+        return SHARING_MIGRATORY;
+    return SHARING_WRITE_SHARED;
+}
+
+void Sharing_tracker::dump ()
+{
+    counter_t count[SHARING_NUM_CLASSES] = {0};
+    counter_t messages[SHARING_NUM_CLASSES] = {0};
+    counter_t cycles[SHARING_NUM_CLASSES] = {0};
+    counter_t total_messages, total_cycles;
+    HASH_MAP<paddr_t, sharing_region_t>::iterator it;
+
+    for (it = regions.begin (); it != regions.end (); it++)
+    {
+        sharing_class_t c = classify (&it->second);
+
+        count[c]++;
+        messages[c] += it->second.messages;
+        cycles[c] += it->second.cycles;
+    }
+    messages[SHARING_UNTRACKED] = untracked_messages;
+    cycles[SHARING_UNTRACKED] = untracked_cycles;
+
+    total_messages = total_cycles = 0;
+    for (int c = 0; c < SHARING_NUM_CLASSES; c++)
+    {
+        total_messages += messages[c];
+        total_cycles += cycles[c];
+    }
+
+    sim_printf ("\nSharing Patterns: %llu regions of %d bytes\n",
+                (unsigned long long)regions.size (), granularity);
+    sim_printf ("  %-18s %8s %10s %7s %10s %7s\n",
+                "Class", "Regions", "Messages", "%", "Bus Cycles", "%");
+    for (int c = 0; c < SHARING_NUM_CLASSES; c++)
+        sim_printf ("  %-18s %8llu %10llu %6.1f%% %10llu %6.1f%%\n", sharing_class_str[c],
+                    (unsigned long long)count[c], (unsigned long long)messages[c],
+                    total_messages ? 100.0 * messages[c] / total_messages : 0.0,
+                    (unsigned long long)cycles[c],
+                    total_cycles ? 100.0 * cycles[c] / total_cycles : 0.0);
+}
+
+/********************************************************************************
+ * Contended line profiler.
+ ********************************************************************************/
+Contended_line_tracker::Contended_line_tracker (int top_k)
+{
+    assert (top_k > 0);
+
+    this->top_k = top_k;
+    this->capacity = top_k * HOT_LINES_FACTOR;
+    this->num_lines = 0;
+    this->total_weight = 0;
+
+    lines = new hot_line_t[capacity]();
+    heap = new int[capacity];
+    index.reserve (capacity);
 }
 
-Read_only_tracker::~Read_only_tracker ()
+Contended_line_tracker::~Contended_line_tracker ()
 {
-    this->read_only_map.clear ();
+    delete [] lines;
+    delete [] heap;
 }
 
-void Read_only_tracker::update (Mreq *request)
+void Contended_line_tracker::heap_swap (int a, int b)
 {
-    paddr_t addr;
-    MAP<paddr_t, bool>::iterator it;
+    int tmp = heap[a];
 
-    addr = request->addr & addr_mask;
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    lines[heap[a]].heap_pos = a;
+    lines[heap[b]].heap_pos = b;
+}
 
-    it = read_only_map.find (addr);
+void Contended_line_tracker::sift_up (int pos)
+{
+    while (pos > 0 && lines[heap[(pos - 1) / 2]].weight > lines[heap[pos]].weight)
+    {
+        heap_swap (pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
 
-    /** Not found.  */
-    if (it == read_only_map.end ())
+void Contended_line_tracker::sift_down (int pos)
+{
+    while (true)
     {
-        if (read_only_map.size () < max_entries)
-            read_only_map[addr] = (request->msg == C_GETIS) ? true : false;
+        int least = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+
+        if (left < num_lines && lines[heap[left]].weight < lines[heap[least]].weight)
+            least = left;
+        if (right < num_lines && lines[heap[right]].weight < lines[heap[least]].weight)
+            least = right;
+        if (least == pos)
+            return;
+
+        heap_swap (pos, least);
+        pos = least;
+    }
+}
+
+/** The line's entry, NULL when it is not tracked.  */
+hot_line_t *Contended_line_tracker::find (paddr_t addr)
+{
+    HASH_MAP<paddr_t, int>::iterator it = index.find (addr);
+
+    return it == index.end () ? NULL : &lines[it->second];
+}
+
+/** The line's entry, displacing the lightest line when full.  */
+hot_line_t *Contended_line_tracker::get (paddr_t addr)
+{
+    hot_line_t *line;
+    counter_t weight;
+
+    if ((line = find (addr)) != NULL)
+        return line;
+
+    if (num_lines < capacity)
+    {
+        line = &lines[num_lines];
+        weight = 0;
+        heap[num_lines] = num_lines;
+        line->heap_pos = num_lines;
+        num_lines++;
     }
     else
     {
-        if (request->msg == C_GETIM || request->msg == C_GETSM)
-            it->second = false;
-    }        
+        line = &lines[heap[0]];
+        weight = line->weight;
+        index.erase (line->addr);
+    }
+
+    int pos = line->heap_pos;
+    memset (line, 0, sizeof (*line));
+    line->addr = addr;
+    line->weight = weight;
+    line->error = weight;
+    line->heap_pos = pos;
+    index[addr] = line - lines;
+
+    sift_up (pos);
+    return line;
 }
 
-int Read_only_tracker::get_nentries (void)
+void Contended_line_tracker::add_weight (hot_line_t *line, counter_t weight)
 {
-    return read_only_map.size ();
+    line->weight += weight;
+    total_weight += weight;
+    sift_down (line->heap_pos);
 }
 
-int Read_only_tracker::get_ro_cnt (void)
+void Contended_line_tracker::bus_grant (Mreq *request)
 {
-    unsigned int ro_cnt;
-    MAP<paddr_t, bool>::iterator it;
+    hot_line_t *line;
+    int node = request->src_mid.nodeID;
+    uint64_t bit = (uint64_t)1 << (node & 63);
+    counter_t invalidations = 0;
 
-    ro_cnt = 0;
-    for (it = read_only_map.begin (); it != read_only_map.end (); it++)
-        if (it->second == true)
-            ro_cnt++;
-    
-    return ro_cnt;
+    switch (request->msg) {
+    case GETS:
+        if ((line = find (request->addr)) != NULL)
+            line->sharers[node >> 6] |= bit;
+        break;
+    case GETM:
+        line = get (request->addr);
+        line->getm++;
+        for (int i = 0; i < LINE_PRESENCE_WORDS; i++)
+        {
+            uint64_t others = line->sharers[i];
+            if (i == (node >> 6))
+                others &= ~bit;
+            invalidations += __builtin_popcountll (others);
+            line->sharers[i] = 0;
+        }
+        line->sharers[node >> 6] = bit;
+        line->invalidations += invalidations;
+        add_weight (line, 1 + invalidations);
+        break;
+    case DATA:
+        /** Writeback, done in this one bus cycle.  */
+        if ((line = find (request->addr)) != NULL)
+        {
+            line->sharers[node >> 6] &= ~bit;
+            line->bus_cycles++;
+        }
+        break;
+    default:
+        break;
+    }
 }
 
-int Read_only_tracker::get_write_cnt (void)
+void Contended_line_tracker::bus_reply (Mreq *reply, timestamp_t cycles)
 {
-    unsigned int write_cnt;
-    MAP<paddr_t, bool>::iterator it;
+    hot_line_t *line;
 
-    write_cnt = 0;
-    for (it = read_only_map.begin (); it != read_only_map.end (); it++)
-        if (it->second == false)
-            write_cnt++;
+    if (reply->src_mid.module_index == L1_M)
+    {
+        line = get (reply->addr);
+        line->c2c++;
+        add_weight (line, 1);
+    }
+    else if ((line = find (reply->addr)) == NULL)
+        return;
+    line->bus_cycles += cycles;
+}
 
-    return write_cnt;
+static bool hot_line_heavier (const hot_line_t &a, const hot_line_t &b)
+{
+    return a.weight != b.weight ? a.weight > b.weight : a.addr < b.addr;
 }
 
-void Read_only_tracker::dump (void)
+void Contended_line_tracker::dump ()
 {
-    unsigned int ro_cnt;
-    unsigned int write_cnt;
-    MAP<paddr_t, bool>::iterator it;
+    VECTOR<hot_line_t> ranked (lines, lines + num_lines);
+    int shown = 0;
+
+    sort (ranked.begin (), ranked.end (), hot_line_heavier);
 
-    ro_cnt = 0;
-    write_cnt = 0;
-    for (it = read_only_map.begin (); it != read_only_map.end (); it++)
-        if (it->second)
-            ro_cnt++;
-        else
-            write_cnt++;
+    sim_printf ("\nContended Lines:  top %d by GETMs + invalidations + $-to-$, %d tracked, "
+                "%llu events\n", top_k, num_lines, (unsigned long long)total_weight);
+    sim_printf ("  %-18s %8s %8s %8s %8s %8s %10s  %s\n",
+                "Addr", "Events", "Error", "GETM", "Invals", "$-to-$", "Bus Cycles", "Sharers");
+
+    for (int i = 0; i < num_lines && shown < top_k; i++)
+    {
+        hot_line_t *line = &ranked[i];
+        char sharers[256];
+        int len = 0;
+
+        /** Nothing guaranteed, its weight may all be inherited.  */
+        if (line->weight == line->error)
+            continue;
+        shown++;
+
+        sharers[0] = '\0';
+        for (int node = 0; node < LINE_PRESENCE_WORDS * 64 && len < (int)sizeof (sharers) - 8; node++)
+            if ((line->sharers[node >> 6] >> (node & 63)) & 1)
+                len += snprintf (sharers + len, sizeof (sharers) - len, "%s%d", len ? "," : "", node);
+        if (!len)
+            snprintf (sharers, sizeof (sharers), "-");
+
+        sim_printf ("  0x%-16llx %8llu %8llu %8llu %8llu %8llu %10llu  %s\n",
+                    (unsigned long long)line->addr, (unsigned long long)line->weight,
+                    (unsigned long long)line->error, (unsigned long long)line->getm,
+                    (unsigned long long)line->invalidations, (unsigned long long)line->c2c,
+                    (unsigned long long)line->bus_cycles, sharers);
+    }
 }
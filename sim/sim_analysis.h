@@ -1,8 +1,10 @@
 #ifndef SIM_ANALYSIS_H
 #define SIM_ANALYSIS_H
 
+#include "line_table.h"
 #include "module.h"
 #include "types.h"
+#include "../protocols/messages.h"
 
 using namespace std;
 
@@ -12,46 +14,184 @@ class ModuleID;
 /** 
  * Reference stream tracker.
  */
-class Ref_stream_entry {
-public:
-    Ref_stream_entry (message_t msg, paddr_t addr, ModuleID mid);
-    ~Ref_stream_entry ();
 
+/** Cache state of a line after an event, else these.  */
+#define REF_STREAM_NO_LINE      0xff
+#define REF_STREAM_UNSETTLED    0xfe
+
+typedef struct {
+    timestamp_t clock;
+    int16_t node;
+    int16_t peer;
+    uint8_t msg;
+} ref_stream_entry_t;
+
+/** Ring of the last depth bus events of one watched line.  */
+typedef struct {
     paddr_t addr;
-    ModuleID mid;
-    message_t msg;   
-};
+    /** Events ever seen, the newest is at (events - 1) % depth.  */
+    counter_t events;
+    ref_stream_entry_t *ring;
+    /** depth x num_nodes, each cache's state after the event.  */
+    uint8_t *states;
+} ref_stream_t;
 
+/**
+ * Bus events of a few watched lines, with the state every cache holds them
+ * in once the event has been processed, kept in fixed rings so one line can
+ * be followed over a long run without logging everything.  The bus is
+ * atomic, so at most one event a cycle and its states are read on the next
+ * bus tick, after all caches have seen it.
+ */
 class Reference_stream_tracker {
 public:
-    Reference_stream_tracker (paddr_t ref_stream_addr, int ref_stream_max);
+    Reference_stream_tracker (int depth);
     ~Reference_stream_tracker ();
 
-    unsigned int ref_stream_max;
-    paddr_t ref_stream_addr;
-    LIST<Ref_stream_entry*> ref_stream;
+    void watch (paddr_t addr);
+    int num_watched (void) { return streams.size (); }
 
-    void update (Mreq *request);
-    void dump ();
+    /** Called by the bus, from the simulator thread.  */
+    void settle (void);
+    void bus_event (Mreq *request);
+
+    /** Safe from fatal_error, a node worker can't read other caches so
+     *  the states of the newest event may show unsettled.  */
+    void dump (void);
+
+private:
+    int depth;
+    VECTOR<ref_stream_t> streams;
+    HASH_MAP<paddr_t, int> index;
+
+    /** Stream whose newest event awaits its states, -1 when none.  */
+    int pending;
 };
 
 /** 
- * Read-only data tracker.
+ * Sharing pattern tracker.
+ */
+typedef enum {
+    SHARING_PRIVATE = 0,
+    SHARING_READ_ONLY,
+    SHARING_MIGRATORY,
+    SHARING_PRODUCER_CONSUMER,
+    SHARING_WRITE_SHARED,
+    SHARING_UNTRACKED,
+    SHARING_NUM_CLASSES
+} sharing_class_t;
+
+extern const char *sharing_class_str[SHARING_NUM_CLASSES];
+
+typedef struct {
+    /** Nodes that sent a GETS or a GETM, one bit per node.  */
+    uint64_t readers[LINE_PRESENCE_WORDS];
+    uint64_t writers[LINE_PRESENCE_WORDS];
+    int16_t last_node;
+    int16_t last_writer;
+    uint8_t last_msg;
+    counter_t getm;
+    /** GETMs right after the same node's GETS, taking the line over from
+     *  another writer: the read-modify-write of migratory data.  */
+    counter_t handoffs;
+    counter_t messages;
+    counter_t cycles;
+} sharing_region_t;
+
+/**
+ * Classifies regions of granularity bytes by how the cores share them, from
+ * the bus requests alone: private, read-only shared, migratory, producer-
+ * consumer (one writer) or write-shared (several writers, not migratory).
+ * The bus messages and cycles of each region are credited to its class at
+ * the end of the run.  At most max_entries regions are tracked, traffic to
+ * regions first seen after that is reported as untracked.
  */
-class Read_only_tracker {
+class Sharing_tracker {
 public:
-    Read_only_tracker (int granularity, int max_entries);
-    ~Read_only_tracker ();
+    Sharing_tracker (int granularity, int max_entries);
+    ~Sharing_tracker ();
+
+    /** Fed by the bus, from the simulator thread.  */
+    void bus_grant (Mreq *request);
+    void bus_reply (Mreq *reply, timestamp_t cycles);
+
+    sharing_class_t classify (sharing_region_t *region);
+    void dump ();
 
+private:
+    int granularity;
     paddr_t addr_mask;
     unsigned int max_entries;
-    MAP<paddr_t, bool> read_only_map;
+    HASH_MAP<paddr_t, sharing_region_t> regions;
+
+    counter_t untracked_messages;
+    counter_t untracked_cycles;
+
+    sharing_region_t *get (paddr_t addr);
+};
+
+/**
+ * Contended line profiler.
+ */
+
+/** Lines tracked per line reported.  */
+#define HOT_LINES_FACTOR        8
+
+typedef struct {
+    paddr_t addr;
+    /** Contention events on the line, GETMs, invalidations and $-to-$
+     *  transfers: the space-saving count.  */
+    counter_t weight;
+    /** Count inherited from the line it displaced, weight overestimates by
+     *  at most this much.  */
+    counter_t error;
+    counter_t getm;
+    counter_t invalidations;
+    counter_t c2c;
+    counter_t bus_cycles;
+    /** Caches that fetched the line since its last GETM, less writebacks.  */
+    uint64_t sharers[LINE_PRESENCE_WORDS];
+    int heap_pos;
+} hot_line_t;
+
+/**
+ * Space-saving heavy hitter summary of cache lines, weighted by contention
+ * events: GETMs, the invalidations they cause and $-to-$ transfers.  A
+ * fixed number of lines is tracked; a line enters on its first contention
+ * event, taking the place of the lightest one and inheriting its weight,
+ * so any line with more than 1/capacity of all contention events is
+ * guaranteed a place whatever the footprint.  Cold and private misses
+ * carry no weight and never displace a line.  Sharers and bus cycles are
+ * counted from the time a line entered.
+ */
+class Contended_line_tracker {
+public:
+    Contended_line_tracker (int top_k);
+    ~Contended_line_tracker ();
+
+    /** Fed by the bus, from the simulator thread.  */
+    void bus_grant (Mreq *request);
+    void bus_reply (Mreq *reply, timestamp_t cycles);
 
-    void update (Mreq *request);
-    int get_nentries (void);
-    int get_ro_cnt (void);
-    int get_write_cnt (void);
     void dump ();
+
+private:
+    int top_k;
+    int capacity;
+    int num_lines;
+    counter_t total_weight;
+
+    hot_line_t *lines;
+    /** Min-heap of lines by weight, heap[0] goes first.  */
+    int *heap;
+    HASH_MAP<paddr_t, int> index;
+
+    hot_line_t *find (paddr_t addr);
+    hot_line_t *get (paddr_t addr);
+    void add_weight (hot_line_t *line, counter_t weight);
+    void heap_swap (int a, int b);
+    void sift_up (int pos);
+    void sift_down (int pos);
 };
 
 #endif // SIM_ANALYSIS_H
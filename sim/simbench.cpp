@@ -0,0 +1,456 @@
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bus.h"
+#include "hash_table.h"
+#include "host_profile.h"
+#include "mreq.h"
+#include "processor.h"
+#include "settings.h"
+#include "sharers.h"
+#include "sim.h"
+#include "trace.h"
+
+/**
+ * Microbenchmarks of the simulator's hot data structures, run by "make
+ * bench".  Each one times a loop of operations on the real classes, built
+ * by a Simulator on empty traces, and reports host ns and heap allocations
+ * (global operator new calls) per operation.
+ */
+Sim_settings settings;
+Simulator *Sim;
+
+static char bench_dir[64];
+static int bench_traces;
+static const char *bench_filter;
+
+/***************************************************************************
+ * Allocation counting and timing.
+ ***************************************************************************/
+static counter_t bench_allocs;
+
+void *operator new (size_t size)
+{
+    void *ptr = malloc (size ? size : 1);
+
+    if (!ptr)
+        throw std::bad_alloc ();
+    bench_allocs++;
+    return ptr;
+}
+
+void *operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void *ptr) throw ()
+{
+    free (ptr);
+}
+
+void operator delete[] (void *ptr) throw ()
+{
+    free (ptr);
+}
+
+static uint64_t start_nsecs;
+static counter_t start_allocs;
+
+static void bench_start (void)
+{
+    start_allocs = bench_allocs;
+    start_nsecs = host_nsecs ();
+}
+
+static void bench_stop (const char *name, counter_t ops)
+{
+    uint64_t nsecs = host_nsecs () - start_nsecs;
+    counter_t allocs = bench_allocs - start_allocs;
+
+    printf ("%-44s %10llu %10.1f %10.3f\n", name, (unsigned long long)ops,
+            ops ? (double)nsecs / ops : 0.0, ops ? (double)allocs / ops : 0.0);
+    fflush (stdout);
+}
+
+static bool bench_enabled (const char *group)
+{
+    return !bench_filter || strstr (group, bench_filter);
+}
+
+/** Line i of a footprint of n (a power of two) lines, visited in an order
+ *  that defeats the host's prefetchers.  */
+static paddr_t bench_line (counter_t i, counter_t n)
+{
+    return (((i * 0x9e3779b1ULL) & (n - 1)) + 0x100000) << settings.cache_line_size_log2;
+}
+
+/***************************************************************************
+ * A Simulator of num_nodes cores with empty traces.
+ ***************************************************************************/
+static void build_sim (int num_nodes, protocol_t protocol)
+{
+    for (; bench_traces < num_nodes; bench_traces++)
+    {
+        char path[128];
+        FILE *file;
+
+        snprintf (path, sizeof (path), "%s/p%d.trace", bench_dir, bench_traces);
+        file = fopen (path, "w");
+        if (!file)
+            fatal_error ("simbench: Unable to create %s\n", path);
+        fclose (file);
+    }
+
+    settings.num_nodes = num_nodes;
+    settings.trace_dir = bench_dir;
+    settings.protocol = protocol;
+
+    Sim = new Simulator ();
+}
+
+static void destroy_sim (void)
+{
+    delete Sim;
+    Sim = NULL;
+}
+
+/***************************************************************************
+ * Benchmarks.
+ ***************************************************************************/
+static void bench_hash_table (void)
+{
+    static const counter_t footprints[] = {1 << 10, 1 << 16, 1 << 20};
+    char name[64];
+
+    for (unsigned int f = 0; f < sizeof (footprints) / sizeof (footprints[0]); f++)
+    {
+        counter_t n = footprints[f];
+        counter_t ops = n > (1 << 21) ? n : (1 << 21);
+        Hash_table *l1;
+
+        build_sim (1, MSI_PRO);
+        l1 = Sim->get_L1 (0);
+
+        snprintf (name, sizeof (name), "Hash_table::get_entry fill %lluK", (unsigned long long)n >> 10);
+        bench_start ();
+        for (counter_t i = 0; i < n; i++)
+            l1->get_entry (bench_line (i, n));
+        bench_stop (name, n);
+
+        snprintf (name, sizeof (name), "Hash_table::get_entry hit %lluK", (unsigned long long)n >> 10);
+        bench_start ();
+        for (counter_t i = 0; i < ops; i++)
+            l1->get_entry (bench_line (i * 7, n));
+        bench_stop (name, ops);
+
+        snprintf (name, sizeof (name), "Hash_table::find_entry miss %lluK", (unsigned long long)n >> 10);
+        bench_start ();
+        for (counter_t i = 0; i < ops; i++)
+            l1->find_entry (bench_line (i, n) + ((paddr_t)1 << 40));
+        bench_stop (name, ops);
+
+        destroy_sim ();
+    }
+}
+
+/** One bus cycle as the main loop runs it.  */
+static void bus_cycle (int snoopers)
+{
+    Sim->events->next_event (&Sim->global_clock);
+    Sim->bus->tick ();
+    for (int i = 0; i < snoopers; i++)
+        Sim->bus->bus_snoop ();
+    Sim->global_clock++;
+}
+
+static void bench_bus (void)
+{
+    static const int snoopers[] = {4, 16, 64, 512};
+    const counter_t ops = 1 << 18;
+    char name[64];
+
+    for (unsigned int s = 0; s < sizeof (snoopers) / sizeof (snoopers[0]); s++)
+    {
+        int n = snoopers[s];
+        ModuleID mc = {n, MC_M};
+
+        build_sim (n, MSI_PRO);
+
+        /** GETS, DATA from memory, and the idle cycle after.  */
+        snprintf (name, sizeof (name), "Bus GETS+DATA transaction, %d snoopers", n);
+        bench_start ();
+        for (counter_t i = 0; i < ops; i++)
+        {
+            ModuleID requester = {(int)(i % n), L1_M};
+            paddr_t addr = bench_line (i, 1 << 12);
+
+            Sim->bus->bus_request (new Mreq (GETS, addr, requester));
+            bus_cycle (n);
+            Sim->bus->bus_request (new Mreq (DATA, addr, mc, requester));
+            bus_cycle (n);
+            bus_cycle (n);
+        }
+        bench_stop (name, ops);
+
+        /** Arbitration with every core queued.  */
+        snprintf (name, sizeof (name), "Bus::bus_request+tick, %d queued", n);
+        bench_start ();
+        for (counter_t i = 0; i < ops; i += n)
+        {
+            for (int j = 0; j < n; j++)
+                Sim->bus->bus_request (new Mreq (DATA, bench_line (i + j, 1 << 12),
+                                                 (ModuleID){j, L1_M}, mc));
+            for (int j = 0; j <= n; j++)
+                bus_cycle (0);
+        }
+        bench_stop (name, ops);
+
+        destroy_sim ();
+    }
+}
+
+static void bench_sharers (void)
+{
+    const counter_t ops = 1 << 22;
+    Sharers sharers;
+    counter_t found = 0;
+
+    bench_start ();
+    for (counter_t i = 0; i < ops; i++)
+    {
+        int node = (i * 37) & 511;
+
+        sharers.add_sharer (node);
+        if (sharers.is_sharer ((node * 5) & 511))
+            found++;
+        sharers.remove_sharer ((node * 11) & 511);
+    }
+    bench_stop ("Sharers add+is+remove", ops);
+
+    bench_start ();
+    for (counter_t i = 0; i < ops; i++)
+        found += sharers.num_sharers ();
+    bench_stop ("Sharers::num_sharers", ops);
+
+    /** Copies go sharer by sharer, far slower than the rest.  */
+    bench_start ();
+    for (counter_t i = 0; i < (ops >> 8); i++)
+    {
+        Sharers copy;
+        copy = sharers;
+        found += copy.is_sharer (i & 511);
+    }
+    bench_stop ("Sharers copy", ops >> 8);
+
+    if (found == 0)
+        printf ("\n");
+}
+
+/** Runs the simulation until no module has anything left to do.  */
+static void run_until_quiet (void)
+{
+    Sim->schedule (Sim->global_clock);
+    while (Sim->events->next_event (&Sim->global_clock))
+    {
+        Sim->run_cycle ();
+        Sim->global_clock++;
+    }
+}
+
+/** Index of state name in the protocol's table, -1 if it has none.  */
+static int state_index (Hash_table *l1, const char *name)
+{
+    const char **names = l1->state_names ();
+
+    for (int i = 0; names[i]; i++)
+        if (!strcmp (names[i], name))
+            return i;
+    return -1;
+}
+
+static void bench_protocols (void)
+{
+    /** MOESIF is still a skeleton that rejects every state.  */
+    static const protocol_t protocols[] = {MI_PRO, MSI_PRO, MESI_PRO, MOSI_PRO, MOESI_PRO};
+    const counter_t ops = 1 << 21;
+    char name[64];
+
+    for (unsigned int p = 0; p < sizeof (protocols) / sizeof (protocols[0]); p++)
+    {
+        Hash_table *l1;
+        Processor *pr;
+        paddr_t addr = bench_line (0, 1);
+        ModuleID mid = {0, PR_M};
+        int modified;
+
+        build_sim (1, protocols[p]);
+        l1 = Sim->get_L1 (0);
+        pr = Sim->get_PR (0);
+        modified = state_index (l1, "M");
+
+        /** Miss the line in with a store, as the main loop would.  */
+        l1->processor_request (new Mreq (STORE, addr, mid));
+        run_until_quiet ();
+        if (l1->line_state (addr) != modified)
+            fatal_error ("simbench: %s never reached M\n", protocol_str[protocols[p]]);
+
+        /** Hits in M: cache dispatch, DATA to the processor, retire.  */
+        for (int op = 0; op < 2; op++)
+        {
+            snprintf (name, sizeof (name), "%s %s hit in M", protocol_str[protocols[p]],
+                      op ? "store" : "load");
+            bench_start ();
+            for (counter_t i = 0; i < ops; i++)
+            {
+                l1->processor_request (new Mreq (op ? STORE : LOAD, addr, mid));
+                l1->tick ();
+                pr->tock ();
+                pr->tick ();
+            }
+            bench_stop (name, ops);
+        }
+
+        destroy_sim ();
+
+        /** Two cores storing to one line in turn: every store is a GETM
+         *  the other cache snoops, invalidating its M copy, and the whole
+         *  bus transaction through to the processor's retire.  */
+        build_sim (2, protocols[p]);
+        snprintf (name, sizeof (name), "%s snooped GETM invalidating M",
+                  protocol_str[protocols[p]]);
+        bench_start ();
+        for (counter_t i = 0; i < (ops >> 6); i++)
+        {
+            ModuleID writer = {(int)(i & 1), PR_M};
+
+            Sim->get_L1 (writer.nodeID)->processor_request (new Mreq (STORE, addr, writer));
+            run_until_quiet ();
+        }
+        bench_stop (name, ops >> 6);
+        if (Sim->get_L1 (1)->line_state (addr) != modified
+            || Sim->get_L1 (0)->line_state (addr) == modified)
+            fatal_error ("simbench: %s GETM never moved the line\n", protocol_str[protocols[p]]);
+
+        destroy_sim ();
+    }
+}
+
+static void bench_traces_parse (void)
+{
+    const counter_t refs = 1 << 21;
+    char text_path[128], bin_path[128];
+    FILE *file;
+    Bin_trace_writer *writer;
+
+    snprintf (text_path, sizeof (text_path), "%s/text.trace", bench_dir);
+    snprintf (bin_path, sizeof (bin_path), "%s/bin.trace", bench_dir);
+
+    file = fopen (text_path, "w");
+    if (!file)
+        fatal_error ("simbench: Unable to create %s\n", text_path);
+    for (counter_t i = 0; i < refs; i++)
+        fprintf (file, "%c 0x%llx\n", (i % 3) ? 'r' : 'w',
+                 (unsigned long long)bench_line (i, 1 << 16));
+    fclose (file);
+
+    file = fopen (bin_path, "w");
+    if (!file)
+        fatal_error ("simbench: Unable to create %s\n", bin_path);
+    writer = new Bin_trace_writer (file, settings.cache_line_size, 1, 0);
+    for (counter_t i = 0; i < refs; i++)
+        writer->put ((i % 3) ? 'r' : 'w', bench_line (i, 1 << 16));
+    writer->flush ();
+    delete writer;
+    fclose (file);
+
+    static const struct {
+        const char *name;
+        const char *path;
+        bool use_mmap;
+    } readers[] = {
+        {"trace parse, text fscanf", text_path, false},
+        {"trace parse, text mmap", text_path, true},
+        {"trace parse, binary", bin_path, false},
+    };
+
+    for (unsigned int r = 0; r < sizeof (readers) / sizeof (readers[0]); r++)
+    {
+        Trace_reader *trace;
+        counter_t n = 0;
+        paddr_t addr;
+        char op;
+
+        bench_start ();
+        trace = open_trace (readers[r].path, readers[r].use_mmap);
+        if (!trace)
+            fatal_error ("simbench: Unable to open %s\n", readers[r].path);
+        while (trace->next (&op, &addr) == TRACE_OK)
+            n++;
+        delete trace;
+        bench_stop (readers[r].name, n);
+
+        if (n != refs)
+            fatal_error ("simbench: %s read %llu of %llu references\n", readers[r].path,
+                         (unsigned long long)n, (unsigned long long)refs);
+    }
+
+    unlink (text_path);
+    unlink (bin_path);
+}
+
+void usage (void)
+{
+    fprintf (stderr, "Usage: simbench [options]\n");
+    fprintf (stderr, "\t-f <group> (only hash_table, bus, sharers, protocol or trace)\n");
+    exit (1);
+}
+
+int main (int argc, char *argv[])
+{
+    int c;
+
+    while ((c = getopt (argc, argv, "hf:")) != -1)
+    {
+        switch (c) {
+        case 'f':
+            bench_filter = optarg;
+            break;
+        default:
+            usage ();
+        }
+    }
+
+    settings.set_defaults ();
+    settings.log_level = LOG_QUIET;
+    snprintf (bench_dir, sizeof (bench_dir), "/tmp/simbench.XXXXXX");
+    if (!mkdtemp (bench_dir))
+        fatal_error ("simbench: Unable to create a directory in /tmp\n");
+
+    printf ("%-44s %10s %10s %10s\n", "benchmark", "ops", "ns/op", "allocs/op");
+
+    if (bench_enabled ("hash_table"))
+        bench_hash_table ();
+    if (bench_enabled ("bus"))
+        bench_bus ();
+    if (bench_enabled ("sharers"))
+        bench_sharers ();
+    if (bench_enabled ("protocol"))
+        bench_protocols ();
+    if (bench_enabled ("trace"))
+        bench_traces_parse ();
+
+    for (int i = 0; i < bench_traces; i++)
+    {
+        char path[128];
+
+        snprintf (path, sizeof (path), "%s/p%d.trace", bench_dir, i);
+        unlink (path);
+    }
+    rmdir (bench_dir);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event_log.h"
+
+/**
+ * Decodes an event log written with -e.  Prints the events in the simulator's
+ * text format, optionally filtered, or summarizes them with -s.
+ */
+void usage (void)
+{
+    fprintf (stderr, "Usage: simlog [options] <event log>\n");
+    fprintf (stderr, "\t-a <addr> (only events on the line holding addr)\n");
+    fprintf (stderr, "\t-n <node> (only events at node)\n");
+    fprintf (stderr, "\t-m <message> (only bus messages of this type, e.g. GETM)\n");
+    fprintf (stderr, "\t-k <event> (only events of this kind, e.g. SNOOP_REQUEST)\n");
+    fprintf (stderr, "\t-s (print a summary instead of the events)\n");
+    exit (1);
+}
+
+static bool is_request (const event_record_t *rec)
+{
+    return rec->kind == EV_PROC_REQUEST || rec->kind == EV_SNOOP_REQUEST ||
+           rec->kind == EV_BUS_GRANT;
+}
+
+int main (int argc, char *argv[])
+{
+    bool filter_addr = false, summary = false;
+    paddr_t addr = 0;
+    int node = -1, kind = -1, msg = -1;
+    char *msg_name = NULL;
+    int c;
+
+    while ((c = getopt (argc, argv, "ha:n:m:k:s")) != -1)
+    {
+        switch (c) {
+        case 'a':
+            filter_addr = true;
+            addr = strtoull (optarg, NULL, 0);
+            break;
+        case 'n':
+            node = atoi (optarg);
+            break;
+        case 'm':
+            msg_name = optarg;
+            break;
+        case 'k':
+            for (kind = 0; kind < EV_NUM_KINDS; kind++)
+                if (!strcasecmp (optarg, event_kind_str[kind]))
+                    break;
+            if (kind == EV_NUM_KINDS)
+            {
+                fprintf (stderr, "simlog: unknown event kind - %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            summary = true;
+            break;
+        default:
+            usage ();
+        }
+    }
+    if (argc - optind != 1)
+        usage ();
+
+    /** Map the log read only.  */
+    const char *path = argv[optind];
+    struct stat st;
+    int fd = open (path, O_RDONLY);
+
+    if (fd < 0 || fstat (fd, &st) < 0 || (size_t)st.st_size < EVENT_LOG_DATA_OFFSET)
+    {
+        fprintf (stderr, "simlog: unable to read %s\n", path);
+        return 1;
+    }
+
+    void *base = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (base == MAP_FAILED)
+    {
+        fprintf (stderr, "simlog: unable to map %s\n", path);
+        return 1;
+    }
+    madvise (base, st.st_size, MADV_SEQUENTIAL);
+
+    const event_log_header_t *header = (const event_log_header_t *)base;
+    const event_record_t *records = (const event_record_t *)((char *)base + EVENT_LOG_DATA_OFFSET);
+
+    if (header->magic != EVENT_LOG_MAGIC || header->version != EVENT_LOG_VERSION ||
+        header->record_size != sizeof (event_record_t) || header->capacity == 0 ||
+        header->num_msgs > EVENT_LOG_MAX_MSGS ||
+        (size_t)st.st_size < EVENT_LOG_DATA_OFFSET + header->capacity * sizeof (event_record_t))
+    {
+        fprintf (stderr, "simlog: %s is not an event log\n", path);
+        return 1;
+    }
+
+    if (msg_name)
+    {
+        for (msg = 0; msg < (int)header->num_msgs; msg++)
+            if (!strcasecmp (msg_name, header->msg_names[msg]))
+                break;
+        if (msg == (int)header->num_msgs)
+        {
+            fprintf (stderr, "simlog: unknown message - %s\n", msg_name);
+            return 1;
+        }
+    }
+
+    /** The ring keeps the last capacity events.  */
+    uint64_t first = 0;
+    if (header->count > header->capacity)
+    {
+        first = header->count - header->capacity;
+        fprintf (stderr, "simlog: ring wrapped, the first %llu events were overwritten\n",
+                 (unsigned long long)first);
+    }
+
+    int line_log2 = header->line_size_log2;
+    counter_t matched = 0;
+    counter_t kinds[EV_NUM_KINDS] = {0};
+    counter_t msgs[EVENT_LOG_MAX_MSGS] = {0};
+    MAP<int, counter_t> nodes;
+    uint64_t first_clock = 0, last_clock = 0;
+    char line[EVENT_LOG_MAX_LINE];
+
+    for (uint64_t i = first; i < header->count; i++)
+    {
+        const event_record_t *rec = &records[i % header->capacity];
+        const char *name = rec->msg < header->num_msgs ? header->msg_names[rec->msg] : "?";
+
+        if (filter_addr && (rec->addr >> line_log2) != (addr >> line_log2))
+            continue;
+        if (node >= 0 && rec->node != node)
+            continue;
+        if (kind >= 0 && rec->kind != kind)
+            continue;
+        if (msg >= 0 && (!is_request (rec) || rec->msg != msg))
+            continue;
+
+        if (!summary)
+        {
+            int len = event_render (rec, line_log2, name, line, sizeof (line));
+            fwrite (line, 1, len, stdout);
+            continue;
+        }
+
+        if (!matched)
+            first_clock = rec->clock;
+        last_clock = rec->clock;
+        matched++;
+        if (rec->kind < EV_NUM_KINDS)
+            kinds[rec->kind]++;
+        if (is_request (rec) && rec->msg < EVENT_LOG_MAX_MSGS)
+            msgs[rec->msg]++;
+        nodes[rec->node]++;
+    }
+
+    if (summary)
+    {
+        printf ("Events:           %8llu of %llu recorded\n",
+                (unsigned long long)matched, (unsigned long long)header->count);
+        printf ("Clock range:      %8llu - %llu\n",
+                (unsigned long long)first_clock, (unsigned long long)last_clock);
+
+        printf ("\nBy event:\n");
+        for (int k = 0; k < EV_NUM_KINDS; k++)
+            if (kinds[k])
+                printf ("  %-16s %8llu\n", event_kind_str[k], (unsigned long long)kinds[k]);
+
+        printf ("\nBy bus message:\n");
+        for (unsigned int m = 0; m < header->num_msgs; m++)
+            if (msgs[m])
+                printf ("  %-16s %8llu\n", header->msg_names[m], (unsigned long long)msgs[m]);
+
+        printf ("\nBy node:\n");
+        MAP<int, counter_t>::iterator it;
+        for (it = nodes.begin (); it != nodes.end (); it++)
+            printf ("  %-16d %8llu\n", it->first, (unsigned long long)it->second);
+    }
+
+    munmap (base, st.st_size);
+    return 0;
+}
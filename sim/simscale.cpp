@@ -0,0 +1,356 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "types.h"
+
+/**
+ * End-to-end scaling harness.  Generates the canonical synthetic workloads
+ * as trace directories (config plus p%d.trace), for 2, 4, 8, ... cores,
+ * runs the simulator on each with every protocol, and writes one CSV row
+ * per run: host wall time, peak RSS and simulated cycles per host second.
+ * Traces only depend on the workload, core count and references per core,
+ * so results files from different builds or hosts line up row for row.
+ * With -f every run uses finite L1s, which also exercises eviction and the
+ * protocol transitions that follow silent evictions of clean lines.
+ */
+void usage (void)
+{
+    fprintf (stderr, "Usage: simscale [options] -s <simulator>\n");
+    fprintf (stderr, "\t-o <results file> (CSV, default scaling.csv)\n");
+    fprintf (stderr, "\t-c <max cores> (powers of two from 2, default 512)\n");
+    fprintf (stderr, "\t-n <references per core> (default 2000)\n");
+    fprintf (stderr, "\t-w <workload> (only this one: private, read_shared, ping_pong,\n"
+                     "\t               false_sharing, migratory or random)\n");
+    fprintf (stderr, "\t-p <protocol> (only this one, default all)\n");
+    fprintf (stderr, "\t-d <directory> (where traces are generated, default /tmp)\n");
+    fprintf (stderr, "\t-f <L1 bytes>,<ways> (finite L1s, default infinite)\n");
+    exit (1);
+}
+
+/** Every protocol_t the simulator takes with -p.  */
+static const char *protocols[] = {"MI", "MSI", "MESI", "MOSI", "MOESI", "MOESIF"};
+#define NUM_PROTOCOLS   (int)(sizeof (protocols) / sizeof (protocols[0]))
+
+typedef enum {
+    WL_PRIVATE = 0,         /** Each core streams through its own lines.  */
+    WL_READ_SHARED,         /** Everyone reads one shared table.  */
+    WL_PING_PONG,           /** Pairs of cores take turns writing a line.  */
+    WL_FALSE_SHARING,       /** 8 cores write their own word of one line.  */
+    WL_MIGRATORY,           /** Objects read-modify-written by one core after another.  */
+    WL_RANDOM,              /** Loads and stores anywhere in the shared table.  */
+    WL_NUM_WORKLOADS
+} workload_t;
+
+static const char *workload_str[WL_NUM_WORKLOADS] = {"private", "read_shared", "ping_pong",
+                                                     "false_sharing", "migratory", "random"};
+
+#define LINE_SIZE       64
+#define SHARED_LINES    4096
+#define OBJECTS         64
+
+/** Deterministic per core stream, the same on every host.  */
+static uint32_t next_random (uint64_t *state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+/** Reference i of core in workload, as an op and an address.  */
+static void make_ref (workload_t workload, int core, int i, uint64_t *rand,
+                      char *op, paddr_t *addr)
+{
+    paddr_t private_base = ((paddr_t)core + 1) << 28;
+    paddr_t shared_base = (paddr_t)1 << 40;
+
+    switch (workload) {
+    case WL_PRIVATE:
+        *op = (i % 4 == 3) ? 'w' : 'r';
+        *addr = private_base + (paddr_t)i * LINE_SIZE;
+        break;
+    case WL_READ_SHARED:
+        *op = 'r';
+        *addr = shared_base + (paddr_t)(next_random (rand) % SHARED_LINES) * LINE_SIZE;
+        break;
+    case WL_PING_PONG:
+        /** Mostly the pair's line, with some private work between.  */
+        if (i % 4 == 3)
+        {
+            *op = 'r';
+            *addr = private_base + (paddr_t)(i % 256) * LINE_SIZE;
+        }
+        else
+        {
+            *op = (i % 4 == 0) ? 'r' : 'w';
+            *addr = shared_base + (paddr_t)(core / 2) * LINE_SIZE;
+        }
+        break;
+    case WL_FALSE_SHARING:
+        *op = (i % 2) ? 'w' : 'r';
+        *addr = shared_base + (paddr_t)(core / 8) * LINE_SIZE + (core % 8) * 8;
+        break;
+    case WL_MIGRATORY:
+        /** Read then write each object, visiting them a core apart.  */
+        *op = (i % 2) ? 'w' : 'r';
+        *addr = shared_base + (paddr_t)((i / 2 + core) % OBJECTS) * LINE_SIZE;
+        break;
+    case WL_RANDOM:
+        *op = (next_random (rand) % 3) ? 'r' : 'w';
+        *addr = shared_base + (paddr_t)(next_random (rand) % SHARED_LINES) * LINE_SIZE;
+        break;
+    default:
+        fprintf (stderr, "simscale: invalid workload - %d\n", workload);
+        exit (1);
+    }
+}
+
+static void generate (const char *dir, workload_t workload, int num_cores, int refs)
+{
+    char path[512];
+    FILE *file;
+
+    if (mkdir (dir, 0755) && errno != EEXIST)
+    {
+        fprintf (stderr, "simscale: unable to create %s\n", dir);
+        exit (1);
+    }
+
+    snprintf (path, sizeof (path), "%s/config", dir);
+    file = fopen (path, "w");
+    if (!file)
+    {
+        fprintf (stderr, "simscale: unable to create %s\n", path);
+        exit (1);
+    }
+    fprintf (file, "%d\n", num_cores);
+    fclose (file);
+
+    for (int core = 0; core < num_cores; core++)
+    {
+        uint64_t rand = ((uint64_t)workload << 32) | core;
+
+        snprintf (path, sizeof (path), "%s/p%d.trace", dir, core);
+        file = fopen (path, "w");
+        if (!file)
+        {
+            fprintf (stderr, "simscale: unable to create %s\n", path);
+            exit (1);
+        }
+        for (int i = 0; i < refs; i++)
+        {
+            paddr_t addr;
+            char op;
+
+            make_ref (workload, core, i, &rand, &op, &addr);
+            fprintf (file, "%c 0x%llx\n", op, (unsigned long long)addr);
+        }
+        fclose (file);
+    }
+}
+
+static void remove_traces (const char *dir, int num_cores)
+{
+    char path[512];
+
+    for (int core = 0; core < num_cores; core++)
+    {
+        snprintf (path, sizeof (path), "%s/p%d.trace", dir, core);
+        unlink (path);
+    }
+    snprintf (path, sizeof (path), "%s/config", dir);
+    unlink (path);
+    snprintf (path, sizeof (path), "%s/output", dir);
+    unlink (path);
+    rmdir (dir);
+}
+
+typedef struct {
+    bool ok;
+    unsigned long long cycles;
+    double wall_secs;
+    long peak_rss_kb;
+} run_result_t;
+
+/** Finite L1 geometry passed to the simulator as -c/-a, NULL for infinite.  */
+static const char *l1_bytes;
+static const char *l1_ways;
+
+/** Runs the simulator quietly, its stats go to dir/output.  */
+static void run (const char *simulator, const char *protocol, const char *dir, run_result_t *result)
+{
+    char output[512];
+    struct timespec start, end;
+    struct rusage usage;
+    int status;
+    pid_t pid;
+
+    snprintf (output, sizeof (output), "%s/output", dir);
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    pid = fork ();
+    if (pid < 0)
+    {
+        fprintf (stderr, "simscale: fork failed\n");
+        exit (1);
+    }
+    if (pid == 0)
+    {
+        int fd = open (output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int null = open ("/dev/null", O_WRONLY);
+
+        if (fd < 0 || null < 0)
+            _exit (127);
+        dup2 (null, 1);
+        dup2 (fd, 2);
+        if (l1_bytes)
+            execl (simulator, simulator, "-p", protocol, "-t", dir, "-l", "quiet",
+                   "-c", l1_bytes, "-a", l1_ways, (char *)NULL);
+        else
+            execl (simulator, simulator, "-p", protocol, "-t", dir, "-l", "quiet", (char *)NULL);
+        _exit (127);
+    }
+
+    if (wait4 (pid, &status, 0, &usage) < 0)
+    {
+        fprintf (stderr, "simscale: wait4 failed\n");
+        exit (1);
+    }
+    clock_gettime (CLOCK_MONOTONIC, &end);
+
+    result->wall_secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    result->peak_rss_kb = usage.ru_maxrss;
+    result->cycles = 0;
+    result->ok = false;
+
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        return;
+
+    FILE *file = fopen (output, "r");
+    char line[256];
+
+    while (file && fgets (line, sizeof (line), file))
+        if (sscanf (line, "Run Time: %llu cycles", &result->cycles) == 1)
+            result->ok = true;
+    if (file)
+        fclose (file);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *simulator = NULL;
+    const char *results_path = "scaling.csv";
+    const char *work_dir = "/tmp";
+    const char *only_protocol = NULL;
+    int only_workload = -1;
+    int max_cores = 512;
+    int refs = 2000;
+    char l1_str[64];
+    char *comma;
+    FILE *results;
+    int c;
+
+    while ((c = getopt (argc, argv, "hs:o:c:n:w:p:d:f:")) != -1)
+    {
+        switch (c) {
+        case 's':
+            simulator = optarg;
+            break;
+        case 'o':
+            results_path = optarg;
+            break;
+        case 'c':
+            max_cores = atoi (optarg);
+            break;
+        case 'n':
+            refs = atoi (optarg);
+            break;
+        case 'w':
+            for (int w = 0; w < WL_NUM_WORKLOADS; w++)
+                if (!strcmp (optarg, workload_str[w]))
+                    only_workload = w;
+            if (only_workload < 0)
+                usage ();
+            break;
+        case 'p':
+            only_protocol = optarg;
+            break;
+        case 'd':
+            work_dir = optarg;
+            break;
+        case 'f':
+            comma = strchr (optarg, ',');
+            if (!comma)
+                usage ();
+            *comma = '\0';
+            l1_bytes = optarg;
+            l1_ways = comma + 1;
+            break;
+        default:
+            usage ();
+        }
+    }
+    if (!simulator || max_cores < 2 || refs <= 0)
+        usage ();
+    if (l1_bytes)
+        snprintf (l1_str, sizeof (l1_str), "%sx%s", l1_bytes, l1_ways);
+    else
+        snprintf (l1_str, sizeof (l1_str), "infinite");
+
+    results = fopen (results_path, "w");
+    if (!results)
+    {
+        fprintf (stderr, "simscale: unable to create %s\n", results_path);
+        return 1;
+    }
+    fprintf (results, "workload,cores,protocol,l1,refs_per_core,status,sim_cycles,"
+                      "wall_secs,peak_rss_kb,cycles_per_sec,refs_per_sec\n");
+
+    for (int w = 0; w < WL_NUM_WORKLOADS; w++)
+    {
+        if (only_workload >= 0 && w != only_workload)
+            continue;
+
+        for (int cores = 2; cores <= max_cores; cores *= 2)
+        {
+            char dir[512];
+
+            snprintf (dir, sizeof (dir), "%s/simscale.%d.%s.%d", work_dir, (int)getpid (),
+                      workload_str[w], cores);
+            generate (dir, (workload_t)w, cores, refs);
+
+            for (int p = 0; p < NUM_PROTOCOLS; p++)
+            {
+                run_result_t result;
+
+                if (only_protocol && strcmp (only_protocol, protocols[p]))
+                    continue;
+
+                run (simulator, protocols[p], dir, &result);
+
+                fprintf (results, "%s,%d,%s,%s,%d,%s,%llu,%.3f,%ld,%.0f,%.0f\n",
+                         workload_str[w], cores, protocols[p], l1_str, refs,
+                         result.ok ? "ok" : "failed",
+                         result.cycles, result.wall_secs, result.peak_rss_kb,
+                         result.ok ? result.cycles / result.wall_secs : 0.0,
+                         result.ok ? (double)cores * refs / result.wall_secs : 0.0);
+                fflush (results);
+
+                fprintf (stderr, "%-14s %4d cores %-7s %-7s %12llu cycles %9.2f s %8ld KB\n",
+                         workload_str[w], cores, protocols[p], result.ok ? "ok" : "failed",
+                         result.cycles, result.wall_secs, result.peak_rss_kb);
+            }
+
+            remove_traces (dir, cores);
+        }
+    }
+
+    fclose (results);
+    return 0;
+}
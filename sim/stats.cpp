@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "hash_table.h"
+#include "memory.h"
+#include "mreq.h"
+#include "settings.h"
+#include "sim.h"
+#include "stats.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+const char *miss_type_str[MISS_NUM_TYPES] = {"cold", "coherence", "capacity", "upgrade"};
+const char *latency_source_str[LAT_NUM_SOURCES] = {"hit", "upgrade", "c2c", "memory"};
+const char *latency_op_str[LAT_NUM_OPS] = {"load", "store"};
+
+/** Percentiles the report prints for every histogram.  */
+static const struct {
+    const char *name;
+    double q;
+} report_percentiles[] = {{"p50", 0.50}, {"p99", 0.99}, {"p999", 0.999}};
+
+#define NUM_REPORT_PERCENTILES  (int)(sizeof (report_percentiles) / sizeof (report_percentiles[0]))
+
+/***************************************************************************
+ * Latency_histogram functions.
+ ***************************************************************************/
+counter_t Latency_histogram::bucket_high (int index)
+{
+    if (index < LAT_SUB_BUCKETS)
+        return index;
+
+    int shift = index / LAT_SUB_BUCKETS - 1;
+    counter_t low = (counter_t)(LAT_SUB_BUCKETS + index % LAT_SUB_BUCKETS) << shift;
+    return low + ((counter_t)1 << shift) - 1;
+}
+
+void Latency_histogram::merge (Latency_histogram *other)
+{
+    if (!other->count)
+        return;
+
+    if (!count || other->min < min)
+        min = other->min;
+    if (other->max > max)
+        max = other->max;
+    count += other->count;
+    sum += other->sum;
+    for (int i = 0; i < LAT_BUCKETS; i++)
+        buckets[i] += other->buckets[i];
+}
+
+counter_t Latency_histogram::percentile (double q)
+{
+    counter_t rank, seen;
+
+    if (!count)
+        return 0;
+
+    rank = (counter_t)(q * count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+
+    seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return bucket_high (i) < max ? bucket_high (i) : max;
+    }
+    return max;
+}
+
+/***************************************************************************
+ * Stats_registry constructor, destructor, and functions.
+ ***************************************************************************/
+Stats_registry::Stats_registry (int num_cores)
+{
+    this->num_cores = num_cores;
+    cores = new core_stats_t[num_cores]();
+    memset (&bus, 0, sizeof (bus));
+    memset (&mem, 0, sizeof (mem));
+    memset (latency, 0, sizeof (latency));
+}
+
+Stats_registry::~Stats_registry ()
+{
+    delete [] cores;
+}
+
+void Stats_registry::report (const char *path, sim_output_mode_t format)
+{
+    const char **state_names = Sim->get_L1 (0)->state_names ();
+    FILE *file;
+
+    memset (latency, 0, sizeof (latency));
+    for (int i = 0; i < num_cores; i++)
+    {
+        Sim->get_L1 (i)->count_states (cores[i].final_state);
+        for (int op = 0; op < LAT_NUM_OPS; op++)
+            for (int src = 0; src < LAT_NUM_SOURCES; src++)
+                latency[op][src].merge (&cores[i].latency[op][src]);
+    }
+
+    file = fopen (path, "w");
+    if (!file)
+        fatal_error ("Stats: Unable to create %s\n", path);
+
+    if (format == OUTPUT_FMT_JSON)
+        write_json (file, state_names);
+    else
+        write_csv (file, state_names);
+
+    fclose (file);
+}
+
+/** Long format, every row is scope,id,group,key,value.  The id is empty
+ *  outside the core scope and the group empty for scalar counters.  */
+static void csv_row (FILE *file, const char *scope, int id, const char *group,
+                     const char *key, counter_t value)
+{
+    if (id >= 0)
+        fprintf (file, "%s,%d,%s,%s,%llu\n", scope, id, group, key, (unsigned long long)value);
+    else
+        fprintf (file, "%s,,%s,%s,%llu\n", scope, group, key, (unsigned long long)value);
+}
+
+static void csv_messages (FILE *file, const char *scope, int id, const char *group,
+                          counter_t *counts)
+{
+    for (int m = MREQ_INVALID + 1; m < MREQ_MESSAGE_NUM; m++)
+        csv_row (file, scope, id, group, Mreq::message_t_str[m], counts[m]);
+}
+
+static void csv_states (FILE *file, int id, const char *group, const char **state_names,
+                        counter_t *counts)
+{
+    for (int s = 0; s < STATS_MAX_STATES && state_names[s]; s++)
+        csv_row (file, "core", id, group, state_names[s], counts[s]);
+}
+
+/** Rows count, sum, min, the percentiles and max, grouped as op_source.  */
+static void csv_latency (FILE *file, const char *scope, int id,
+                         Latency_histogram latency[LAT_NUM_OPS][LAT_NUM_SOURCES])
+{
+    char group[64];
+
+    for (int op = 0; op < LAT_NUM_OPS; op++)
+        for (int src = 0; src < LAT_NUM_SOURCES; src++)
+        {
+            Latency_histogram *h = &latency[op][src];
+
+            snprintf (group, sizeof (group), "latency_%s_%s", latency_op_str[op],
+                      latency_source_str[src]);
+            csv_row (file, scope, id, group, "count", h->count);
+            csv_row (file, scope, id, group, "sum", h->sum);
+            csv_row (file, scope, id, group, "min", h->min);
+            for (int p = 0; p < NUM_REPORT_PERCENTILES; p++)
+                csv_row (file, scope, id, group, report_percentiles[p].name,
+                         h->percentile (report_percentiles[p].q));
+            csv_row (file, scope, id, group, "max", h->max);
+        }
+}
+
+void Stats_registry::write_csv (FILE *file, const char **state_names)
+{
+    fprintf (file, "scope,id,group,key,value\n");
+
+    csv_row (file, "run", -1, "", "cores", num_cores);
+    csv_row (file, "run", -1, "", "cycles", Sim->global_clock);
+    csv_row (file, "run", -1, "", "cache_misses", Sim->cache_misses.value ());
+    csv_row (file, "run", -1, "", "cache_accesses", Sim->cache_accesses.value ());
+    csv_row (file, "run", -1, "", "silent_upgrades", Sim->silent_upgrades.value ());
+    csv_row (file, "run", -1, "", "cache_to_cache_transfers", Sim->cache_to_cache_transfers.value ());
+    csv_row (file, "run", -1, "", "writebacks", Sim->writebacks.value ());
+
+    csv_row (file, "bus", -1, "", "busy_cycles", bus.busy_cycles);
+    csv_messages (file, "bus", -1, "messages", bus.messages);
+
+    csv_messages (file, "memory", -1, "requests", mem.requests);
+    csv_row (file, "memory", -1, "", "busy_cycles", mem.busy_cycles);
+    csv_row (file, "memory", -1, "", "responses", mem.responses);
+    csv_row (file, "memory", -1, "", "writebacks", mem.writebacks);
+    csv_row (file, "memory", -1, "", "cancelled", mem.cancelled);
+
+    csv_latency (file, "latency", -1, latency);
+
+    for (int i = 0; i < num_cores; i++)
+    {
+        core_stats_t *c = &cores[i];
+
+        csv_row (file, "core", i, "", "loads", c->loads);
+        csv_row (file, "core", i, "", "stores", c->stores);
+        csv_row (file, "core", i, "", "cache_to_cache", c->cache_to_cache);
+        csv_row (file, "core", i, "", "writebacks", c->writebacks);
+        for (int t = 0; t < MISS_NUM_TYPES; t++)
+            csv_row (file, "core", i, "misses", miss_type_str[t], c->misses[t]);
+        csv_states (file, i, "access_state", state_names, c->access_state);
+        csv_states (file, i, "final_state", state_names, c->final_state);
+        csv_messages (file, "core", i, "bus_sent", c->bus_sent);
+        csv_messages (file, "core", i, "snooped", c->snooped);
+        csv_latency (file, "core", i, c->latency);
+    }
+}
+
+static void json_messages (FILE *file, const char *indent, const char *group, counter_t *counts)
+{
+    fprintf (file, "%s\"%s\": {", indent, group);
+    for (int m = MREQ_INVALID + 1; m < MREQ_MESSAGE_NUM; m++)
+        fprintf (file, "%s\"%s\": %llu", m == MREQ_INVALID + 1 ? "" : ", ",
+                 Mreq::message_t_str[m], (unsigned long long)counts[m]);
+    fprintf (file, "}");
+}
+
+static void json_states (FILE *file, const char *group, const char **state_names, counter_t *counts)
+{
+    fprintf (file, "      \"%s\": {", group);
+    for (int s = 0; s < STATS_MAX_STATES && state_names[s]; s++)
+        fprintf (file, "%s\"%s\": %llu", s ? ", " : "", state_names[s],
+                 (unsigned long long)counts[s]);
+    fprintf (file, "}");
+}
+
+static void json_latency (FILE *file, const char *indent,
+                          Latency_histogram latency[LAT_NUM_OPS][LAT_NUM_SOURCES])
+{
+    fprintf (file, "%s\"latency\": {", indent);
+    for (int op = 0; op < LAT_NUM_OPS; op++)
+    {
+        fprintf (file, "%s\n%s  \"%s\": {", op ? "," : "", indent, latency_op_str[op]);
+        for (int src = 0; src < LAT_NUM_SOURCES; src++)
+        {
+            Latency_histogram *h = &latency[op][src];
+
+            fprintf (file, "%s\n%s    \"%s\": {\"count\": %llu, \"sum\": %llu, \"min\": %llu",
+                     src ? "," : "", indent, latency_source_str[src],
+                     (unsigned long long)h->count, (unsigned long long)h->sum,
+                     (unsigned long long)h->min);
+            for (int p = 0; p < NUM_REPORT_PERCENTILES; p++)
+                fprintf (file, ", \"%s\": %llu", report_percentiles[p].name,
+                         (unsigned long long)h->percentile (report_percentiles[p].q));
+            fprintf (file, ", \"max\": %llu}", (unsigned long long)h->max);
+        }
+        fprintf (file, "}");
+    }
+    fprintf (file, "}");
+}
+
+void Stats_registry::write_json (FILE *file, const char **state_names)
+{
+    fprintf (file, "{\n");
+    fprintf (file, "  \"run\": {\"protocol\": \"%s\", \"cores\": %d, \"cycles\": %llu, "
+             "\"cache_misses\": %llu, \"cache_accesses\": %llu, \"silent_upgrades\": %llu, "
+             "\"cache_to_cache_transfers\": %llu, \"writebacks\": %llu},\n",
+             protocol_str[settings.protocol], num_cores, (unsigned long long)Sim->global_clock,
+             (unsigned long long)Sim->cache_misses.value (),
+             (unsigned long long)Sim->cache_accesses.value (),
+             (unsigned long long)Sim->silent_upgrades.value (),
+             (unsigned long long)Sim->cache_to_cache_transfers.value (),
+             (unsigned long long)Sim->writebacks.value ());
+
+    fprintf (file, "  \"bus\": {\"busy_cycles\": %llu,\n", (unsigned long long)bus.busy_cycles);
+    json_messages (file, "    ", "messages", bus.messages);
+    fprintf (file, "},\n");
+
+    fprintf (file, "  \"memory\": {\"busy_cycles\": %llu, \"responses\": %llu, "
+             "\"writebacks\": %llu, \"cancelled\": %llu,\n",
+             (unsigned long long)mem.busy_cycles, (unsigned long long)mem.responses,
+             (unsigned long long)mem.writebacks, (unsigned long long)mem.cancelled);
+    json_messages (file, "    ", "requests", mem.requests);
+    fprintf (file, "},\n");
+
+    json_latency (file, "  ", latency);
+    fprintf (file, ",\n");
+
+    fprintf (file, "  \"cores\": [\n");
+    for (int i = 0; i < num_cores; i++)
+    {
+        core_stats_t *c = &cores[i];
+
+        fprintf (file, "    {\"core\": %d, \"loads\": %llu, \"stores\": %llu, "
+                 "\"cache_to_cache\": %llu, \"writebacks\": %llu,\n", i,
+                 (unsigned long long)c->loads, (unsigned long long)c->stores,
+                 (unsigned long long)c->cache_to_cache, (unsigned long long)c->writebacks);
+
+        fprintf (file, "      \"misses\": {");
+        for (int t = 0; t < MISS_NUM_TYPES; t++)
+            fprintf (file, "%s\"%s\": %llu", t ? ", " : "", miss_type_str[t],
+                     (unsigned long long)c->misses[t]);
+        fprintf (file, "},\n");
+
+        json_states (file, "access_state", state_names, c->access_state);
+        fprintf (file, ",\n");
+        json_states (file, "final_state", state_names, c->final_state);
+        fprintf (file, ",\n");
+        json_messages (file, "      ", "bus_sent", c->bus_sent);
+        fprintf (file, ",\n");
+        json_messages (file, "      ", "snooped", c->snooped);
+        fprintf (file, ",\n");
+        json_latency (file, "      ", c->latency);
+        fprintf (file, "}%s\n", i < num_cores - 1 ? "," : "");
+    }
+    fprintf (file, "  ]\n");
+    fprintf (file, "}\n");
+}
+
+/***************************************************************************
+ * Stats_series constructor, destructor, and functions.
+ ***************************************************************************/
+Stats_series::Stats_series (const char *path, long long interval)
+{
+    if (interval <= 0)
+        fatal_error ("Stats: Invalid sampling interval - %lld\n", interval);
+
+    this->interval = interval;
+    next_sample = interval;
+
+    last_clock = 0;
+    last_accesses = 0;
+    last_misses = 0;
+    last_c2c = 0;
+    last_bus_busy = 0;
+    last_mem_busy = 0;
+
+    file = fopen (path, "w");
+    if (!file)
+        fatal_error ("Stats: Unable to create %s\n", path);
+
+    fprintf (file, "cycle,accesses,misses,miss_rate,bus_util,bus_queue,bus_queue_max,"
+             "mc_occupancy,c2c_transfers\n");
+}
+
+Stats_series::~Stats_series ()
+{
+    fclose (file);
+}
+
+/** Row for cycles [last_clock, when).  Transactions still in progress are
+ *  counted up to when, they add the rest of their cycles once complete.  */
+void Stats_series::sample (timestamp_t when)
+{
+    Stats_registry *stats = Sim->stats;
+    Bus *bus = Sim->bus;
+    Memory_controller *mc = Sim->get_MC (settings.num_nodes);
+
+    counter_t accesses = Sim->cache_accesses.value ();
+    counter_t misses = Sim->cache_misses.value ();
+    counter_t c2c = Sim->cache_to_cache_transfers.value ();
+    counter_t bus_busy = stats->bus.busy_cycles;
+    counter_t mem_busy = stats->mem.busy_cycles;
+    double cycles = (double)(when - last_clock);
+
+    if (bus->request_in_progress)
+        bus_busy += when - bus->grant_time;
+    if (mc->request_in_progress)
+        mem_busy += when - mc->request_time;
+
+    fprintf (file, "%llu,%llu,%llu,%.4f,%.4f,%llu,%llu,%.4f,%llu\n",
+             (unsigned long long)when,
+             (unsigned long long)(accesses - last_accesses),
+             (unsigned long long)(misses - last_misses),
+             accesses > last_accesses ? (double)(misses - last_misses) / (accesses - last_accesses) : 0.0,
+             (bus_busy - last_bus_busy) / cycles,
+             (unsigned long long)bus->pending_requests.size (),
+             (unsigned long long)stats->bus.queue_max,
+             (mem_busy - last_mem_busy) / cycles,
+             (unsigned long long)(c2c - last_c2c));
+
+    last_clock = when;
+    last_accesses = accesses;
+    last_misses = misses;
+    last_c2c = c2c;
+    last_bus_busy = bus_busy;
+    last_mem_busy = mem_busy;
+    stats->bus.queue_max = bus->pending_requests.size ();
+}
+
+void Stats_series::finish (timestamp_t now)
+{
+    advance (now);
+    if (now > last_clock)
+        sample (now);
+    fflush (file);
+}
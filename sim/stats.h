@@ -0,0 +1,193 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "enums.h"
+#include "types.h"
+#include "../protocols/messages.h"
+
+/** Why a processor access had to go to the bus.  */
+typedef enum {
+    MISS_COLD = 0,          /** First touch of the line by this cache.  */
+    MISS_COHERENCE,         /** Invalidated by another cache.  */
+    MISS_CAPACITY,          /** Evicted from a finite cache.  */
+    MISS_UPGRADE,           /** Held without write permission.  */
+    MISS_NUM_TYPES
+} miss_type_t;
+
+extern const char *miss_type_str[MISS_NUM_TYPES];
+
+/** Where a processor request's data came from.  An upgrade went to the bus
+ *  for write permission on a line it already held, with or without DATA.  */
+typedef enum {
+    LAT_HIT = 0,
+    LAT_UPGRADE,
+    LAT_C2C,
+    LAT_MEMORY,
+    LAT_NUM_SOURCES
+} latency_source_t;
+
+extern const char *latency_source_str[LAT_NUM_SOURCES];
+
+/** Loads and stores get separate histograms.  */
+typedef enum {
+    LAT_LOAD = 0,
+    LAT_STORE,
+    LAT_NUM_OPS
+} latency_op_t;
+
+extern const char *latency_op_str[LAT_NUM_OPS];
+
+/** HDR style buckets: LAT_SUB_BUCKETS linear sub-buckets per power of two,
+ *  so a value is reported at most 1/LAT_SUB_BUCKETS too high.  Latencies
+ *  past 2^LAT_MAX_BITS cycles share the last bucket.  */
+#define LAT_SUB_BITS            4
+#define LAT_SUB_BUCKETS         (1 << LAT_SUB_BITS)
+#define LAT_MAX_BITS            40
+#define LAT_BUCKETS             ((LAT_MAX_BITS - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS)
+
+/** Log bucketed latency histogram.  Zero filled is empty, so it can live
+ *  in the value initialized core_stats_t array.  */
+class Latency_histogram {
+public:
+    counter_t count;
+    counter_t sum;
+    counter_t min;
+    counter_t max;
+    counter_t buckets[LAT_BUCKETS];
+
+    void record (counter_t value)
+    {
+        if (!count || value < min)
+            min = value;
+        if (value > max)
+            max = value;
+        count++;
+        sum += value;
+        buckets[bucket (value)]++;
+    }
+
+    void merge (Latency_histogram *other);
+
+    /** Highest value of the bucket holding quantile q, 0 when empty.  */
+    counter_t percentile (double q);
+
+private:
+    static int bucket (counter_t value)
+    {
+        if (value < LAT_SUB_BUCKETS)
+            return (int)value;
+
+        int shift = 63 - __builtin_clzll (value) - LAT_SUB_BITS;
+        int index = (shift + 1) * LAT_SUB_BUCKETS + (int)((value >> shift) & (LAT_SUB_BUCKETS - 1));
+        return index < LAT_BUCKETS ? index : LAT_BUCKETS - 1;
+    }
+    static counter_t bucket_high (int index);
+};
+
+/** More than any protocol's states, transient ones included.  */
+#define STATS_MAX_STATES        16
+
+/** Counters of one core.  Only the node owning the core bumps them, so
+ *  parallel workers need no per-worker slots, just the trailing pad to keep
+ *  neighbouring cores off each other's cache lines.  */
+typedef struct {
+    counter_t loads;
+    counter_t stores;
+    counter_t misses[MISS_NUM_TYPES];
+    counter_t access_state[STATS_MAX_STATES];
+    counter_t final_state[STATS_MAX_STATES];
+    counter_t bus_sent[MREQ_MESSAGE_NUM];
+    counter_t snooped[MREQ_MESSAGE_NUM];
+    counter_t cache_to_cache;
+    counter_t writebacks;
+    Latency_histogram latency[LAT_NUM_OPS][LAT_NUM_SOURCES];
+    char pad[64];
+} core_stats_t;
+
+/** Bus and memory controller counters, bumped from the simulator thread.  */
+typedef struct {
+    counter_t busy_cycles;
+    counter_t messages[MREQ_MESSAGE_NUM];
+    /** Deepest pending_requests since the last series sample.  */
+    counter_t queue_max;
+} bus_stats_t;
+
+typedef struct {
+    counter_t busy_cycles;
+    counter_t requests[MREQ_MESSAGE_NUM];
+    counter_t responses;
+    counter_t writebacks;
+    counter_t cancelled;
+} mem_stats_t;
+
+/**
+ * Structured end of run statistics: per core, per protocol state and per
+ * message type counters next to the global Sim counters.  Written to
+ * report_file as CSV, one scope,id,group,key,value row per counter, or as a
+ * single JSON object, as report_output selects.  The stderr report is left
+ * unchanged.
+ */
+class Stats_registry {
+public:
+    Stats_registry (int num_cores);
+    ~Stats_registry ();
+
+    core_stats_t *core (int node) { return &cores[node]; }
+    bus_stats_t bus;
+    mem_stats_t mem;
+
+    /** Collects the final line states and writes the report.  */
+    void report (const char *path, sim_output_mode_t format);
+
+private:
+    int num_cores;
+    core_stats_t *cores;
+
+    /** All cores together.  */
+    Latency_histogram latency[LAT_NUM_OPS][LAT_NUM_SOURCES];
+
+    void write_csv (FILE *file, const char **state_names);
+    void write_json (FILE *file, const char **state_names);
+};
+
+/**
+ * Interval time series of the registry.  Every interval cycles a row goes
+ * to a CSV file, one column per metric: miss rate, bus utilization, bus
+ * queue depth, memory controller occupancy and $-to-$ transfers.  Cycles the
+ * simulator skips still get their rows, so the file is evenly spaced.
+ */
+class Stats_series {
+public:
+    Stats_series (const char *path, long long interval);
+    ~Stats_series ();
+
+    /** Writes a row for every interval that ended before cycle now.  */
+    void advance (timestamp_t now)
+    {
+        while (next_sample <= now)
+        {
+            sample (next_sample);
+            next_sample += interval;
+        }
+    }
+
+    /** Closes the last, possibly shorter, interval at cycle now.  */
+    void finish (timestamp_t now);
+
+private:
+    FILE *file;
+    timestamp_t interval;
+    timestamp_t next_sample;
+
+    /** Totals at the previous row.  */
+    timestamp_t last_clock;
+    counter_t last_accesses;
+    counter_t last_misses;
+    counter_t last_c2c;
+    counter_t last_bus_busy;
+    counter_t last_mem_busy;
+
+    void sample (timestamp_t when);
+};
+
+#endif /*STATS_H_*/
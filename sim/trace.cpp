@@ -0,0 +1,335 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+uint32_t trace_checksum (const unsigned char *buf, size_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/***************************************************************************
+ * Text_trace_reader constructor, destructor, and functions.
+ ***************************************************************************/
+Text_trace_reader::Text_trace_reader (FILE *infile)
+{
+    this->infile = infile;
+}
+
+Text_trace_reader::~Text_trace_reader ()
+{
+    fclose (infile);
+}
+
+trace_status_t Text_trace_reader::next (char *op, paddr_t *addr)
+{
+    if (fscanf (infile, "%c 0x%llx\n", op, (unsigned long long int*)addr) == 2)
+        return TRACE_OK;
+    return TRACE_END;
+}
+
+uint64_t Text_trace_reader::bytes_read (void)
+{
+    off_t pos = ftello (infile);
+
+    return pos < 0 ? 0 : (uint64_t)pos;
+}
+
+/***************************************************************************
+ * Mmap_trace_reader constructor, destructor, and functions.
+ ***************************************************************************/
+Mmap_trace_reader::Mmap_trace_reader (int fd, size_t size)
+{
+    this->size = size;
+    this->pos = 0;
+    this->readahead_end = 0;
+    this->data = NULL;
+
+    /** mmap refuses empty files, which simply have no references.  */
+    if (size > 0)
+    {
+        void *map = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        assert (map != MAP_FAILED && "Mmap_trace_reader: Unable to map trace.");
+        madvise (map, size, MADV_SEQUENTIAL);
+        data = (const unsigned char *)map;
+    }
+    close (fd);
+}
+
+Mmap_trace_reader::~Mmap_trace_reader ()
+{
+    if (data)
+        munmap ((void *)data, size);
+}
+
+static inline bool is_space (unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int hex_digit (unsigned char c)
+{
+    if ((unsigned char)(c - '0') < 10)
+        return c - '0';
+    c |= 0x20;
+    if ((unsigned char)(c - 'a') < 6)
+        return c - 'a' + 10;
+    return -1;
+}
+
+trace_status_t Mmap_trace_reader::next (char *op, paddr_t *addr)
+{
+    paddr_t value = 0;
+    size_t start;
+    int digit;
+
+    if (pos >= size)
+        return TRACE_END;
+
+    if (pos >= readahead_end)
+    {
+        size_t page = pos & ~(size_t)(sysconf (_SC_PAGESIZE) - 1);
+
+        readahead_end = min (size, pos + TRACE_MMAP_READAHEAD);
+        madvise ((void *)(data + page), readahead_end - page, MADV_WILLNEED);
+    }
+
+    /** "%c 0x%llx\n"  */
+    *op = data[pos++];
+    while (pos < size && is_space (data[pos]))
+        pos++;
+    if (pos + 1 >= size || data[pos] != '0' || data[pos + 1] != 'x')
+        return TRACE_END;
+    pos += 2;
+
+    start = pos;
+    while (pos < size && (digit = hex_digit (data[pos])) >= 0)
+    {
+        value = (value << 4) | digit;
+        pos++;
+    }
+    if (pos == start)
+        return TRACE_END;
+
+    while (pos < size && is_space (data[pos]))
+        pos++;
+
+    *addr = value;
+    return TRACE_OK;
+}
+
+/***************************************************************************
+ * Bin_trace_reader constructor, destructor, and functions.
+ ***************************************************************************/
+Bin_trace_reader::Bin_trace_reader (FILE *infile, trace_header_t *header)
+{
+    this->infile = infile;
+    this->header = *header;
+
+    buf_size = TRACE_BIN_BLOCK_REFS * TRACE_BIN_MAX_VARINT;
+    buf = (unsigned char *)malloc (buf_size);
+    assert (buf && "Bin_trace_reader: Unable to alloc block buffer.");
+
+    pos = 0;
+    buf_len = 0;
+    refs_left = 0;
+    prev_addr = 0;
+}
+
+Bin_trace_reader::~Bin_trace_reader ()
+{
+    free (buf);
+    fclose (infile);
+}
+
+trace_status_t Bin_trace_reader::read_block (void)
+{
+    trace_block_t block;
+
+    if (fread (&block, sizeof (block), 1, infile) != 1)
+        return TRACE_END;
+
+    if (block.num_bytes > (uint64_t)block.num_refs * TRACE_BIN_MAX_VARINT)
+        return TRACE_CORRUPT;
+
+    if (block.num_bytes > buf_size)
+    {
+        buf_size = block.num_bytes;
+        buf = (unsigned char *)realloc (buf, buf_size);
+        assert (buf && "Bin_trace_reader: Unable to grow block buffer.");
+    }
+
+    if (fread (buf, 1, block.num_bytes, infile) != block.num_bytes ||
+        trace_checksum (buf, block.num_bytes) != block.checksum)
+        return TRACE_CORRUPT;
+
+    pos = 0;
+    buf_len = block.num_bytes;
+    refs_left = block.num_refs;
+    prev_addr = 0;
+    return TRACE_OK;
+}
+
+trace_status_t Bin_trace_reader::next (char *op, paddr_t *addr)
+{
+    uint64_t rec = 0;
+    int shift = 0;
+
+    while (refs_left == 0)
+    {
+        trace_status_t status = read_block ();
+        if (status != TRACE_OK)
+            return status;
+    }
+
+    do {
+        if (shift > 63 || pos == buf_len)
+            return TRACE_CORRUPT;
+        rec |= (uint64_t)(buf[pos] & 0x7f) << shift;
+        shift += 7;
+    } while (buf[pos++] & 0x80);
+
+    *op = (rec & 1) ? 'w' : 'r';
+    rec >>= 1;
+    prev_addr += (paddr_t)((rec >> 1) ^ -(rec & 1));
+    *addr = prev_addr;
+    refs_left--;
+
+    return TRACE_OK;
+}
+
+/** Whole blocks, the one being decoded counts as read.  */
+uint64_t Bin_trace_reader::bytes_read (void)
+{
+    off_t pos = ftello (infile);
+
+    return pos < 0 ? 0 : (uint64_t)pos;
+}
+
+/***************************************************************************
+ * Format detection.
+ ***************************************************************************/
+Trace_reader *open_trace (const char *path, bool use_mmap)
+{
+    FILE *infile;
+    trace_header_t header;
+    Trace_reader *reader;
+    struct stat st;
+
+    infile = fopen (path, "r");
+    if (!infile)
+        return NULL;
+    if (fstat (fileno (infile), &st) < 0)
+    {
+        fclose (infile);
+        return NULL;
+    }
+
+    if (fread (&header, sizeof (header), 1, infile) == 1 &&
+        header.magic == TRACE_BIN_MAGIC &&
+        header.version == TRACE_BIN_VERSION)
+        reader = new Bin_trace_reader (infile, &header);
+    else if (use_mmap)
+    {
+        int fd = dup (fileno (infile));
+
+        fclose (infile);
+        if (fd < 0)
+            return NULL;
+        reader = new Mmap_trace_reader (fd, st.st_size);
+    }
+    else
+    {
+        rewind (infile);
+        reader = new Text_trace_reader (infile);
+    }
+
+    reader->file_size = st.st_size;
+    return reader;
+}
+
+/***************************************************************************
+ * Bin_trace_writer constructor, destructor, and functions.
+ ***************************************************************************/
+Bin_trace_writer::Bin_trace_writer (FILE *outfile, int line_size, int num_cores, int core)
+{
+    trace_header_t header;
+
+    this->outfile = outfile;
+
+    buf = (unsigned char *)malloc (TRACE_BIN_BLOCK_REFS * TRACE_BIN_MAX_VARINT);
+    assert (buf && "Bin_trace_writer: Unable to alloc block buffer.");
+    pos = 0;
+    num_refs = 0;
+    prev_addr = 0;
+
+    header.magic = TRACE_BIN_MAGIC;
+    header.version = TRACE_BIN_VERSION;
+    header.line_size = line_size;
+    header.num_cores = num_cores;
+    header.core = core;
+    fwrite (&header, sizeof (header), 1, outfile);
+    bytes_written = sizeof (header);
+}
+
+Bin_trace_writer::~Bin_trace_writer ()
+{
+    flush ();
+    free (buf);
+}
+
+bool Bin_trace_writer::put (char op, paddr_t addr)
+{
+    int64_t delta = (int64_t)(addr - prev_addr);
+    uint64_t rec;
+
+    if (delta < -TRACE_BIN_DELTA_LIMIT || delta >= TRACE_BIN_DELTA_LIMIT)
+        return false;
+
+    rec = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    rec = (rec << 1) | (op == 'w');
+    prev_addr = addr;
+
+    while (rec >= 0x80)
+    {
+        buf[pos++] = (unsigned char)(rec | 0x80);
+        rec >>= 7;
+    }
+    buf[pos++] = (unsigned char)rec;
+
+    if (++num_refs == TRACE_BIN_BLOCK_REFS)
+        flush ();
+    return true;
+}
+
+void Bin_trace_writer::flush (void)
+{
+    trace_block_t block;
+
+    if (num_refs == 0)
+        return;
+
+    block.num_refs = num_refs;
+    block.num_bytes = pos;
+    block.checksum = trace_checksum (buf, pos);
+    fwrite (&block, sizeof (block), 1, outfile);
+    fwrite (buf, 1, pos, outfile);
+    bytes_written += sizeof (block) + pos;
+
+    pos = 0;
+    num_refs = 0;
+    prev_addr = 0;
+}
@@ -0,0 +1,160 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "types.h"
+
+/**
+ * Binary trace layout.  A file header, then blocks of references.  Each
+ * reference is one varint holding (zigzag (addr - previous addr) << 1) | is
+ * store, with the previous address reset to 0 at every block so a block
+ * decodes on its own.  The block header carries an FNV-1a checksum of its
+ * payload.  Header fields are in host byte order, and deltas must fit in
+ * 62 bits: the zigzag and the store bit each take one of the 64.  Readers
+ * check the header against the run, writers refuse larger deltas.
+ */
+#define TRACE_BIN_MAGIC         0x42544343      /** "CCTB" */
+#define TRACE_BIN_VERSION       1
+
+/** References per block written by Bin_trace_writer.  */
+#define TRACE_BIN_BLOCK_REFS    4096
+
+/** Worst case encoded size of one reference.  */
+#define TRACE_BIN_MAX_VARINT    10
+
+/** Deltas between consecutive addresses lie in [-limit, limit).  */
+#define TRACE_BIN_DELTA_LIMIT   ((int64_t)1 << 62)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t line_size;
+    uint32_t num_cores;
+    uint32_t core;
+} trace_header_t;
+
+typedef struct {
+    uint32_t num_refs;
+    uint32_t num_bytes;
+    uint32_t checksum;
+} trace_block_t;
+
+typedef enum {
+    TRACE_OK,
+    TRACE_END,
+    TRACE_CORRUPT
+} trace_status_t;
+
+uint32_t trace_checksum (const unsigned char *buf, size_t len);
+
+/**
+ * Source of processor references.  next () fills in the operation ('r' or
+ * 'w' for well formed traces) and the address.  bytes_read () and
+ * file_size give the progress through the trace file.
+ */
+class Trace_reader {
+public:
+    Trace_reader () { file_size = 0; }
+    virtual ~Trace_reader () {}
+
+    virtual trace_status_t next (char *op, paddr_t *addr) = 0;
+    virtual uint64_t bytes_read (void) = 0;
+
+    /** The file header of a binary trace, NULL for text.  */
+    virtual const trace_header_t *bin_header (void) { return NULL; }
+
+    /** Set by open_trace, 0 when unknown.  */
+    uint64_t file_size;
+};
+
+/** The original "r 0x..." / "w 0x..." text format.  */
+class Text_trace_reader : public Trace_reader {
+public:
+    Text_trace_reader (FILE *infile);
+    ~Text_trace_reader ();
+
+    trace_status_t next (char *op, paddr_t *addr);
+    uint64_t bytes_read (void);
+
+private:
+    FILE *infile;
+};
+
+/**
+ * Same text format, parsed straight out of an mmap of the file.  Accepts
+ * what the fscanf reader accepts for well formed traces and stops at the
+ * first line it cannot parse, as fscanf does.
+ */
+class Mmap_trace_reader : public Trace_reader {
+public:
+    Mmap_trace_reader (int fd, size_t size);
+    ~Mmap_trace_reader ();
+
+    trace_status_t next (char *op, paddr_t *addr);
+    uint64_t bytes_read (void) { return pos; }
+
+private:
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+
+    /** End of the range most recently handed to madvise (WILLNEED).  */
+    size_t readahead_end;
+};
+
+/** Bytes of text asked for ahead of the parser.  */
+#define TRACE_MMAP_READAHEAD    (1 << 20)
+
+class Bin_trace_reader : public Trace_reader {
+public:
+    Bin_trace_reader (FILE *infile, trace_header_t *header);
+    ~Bin_trace_reader ();
+
+    trace_header_t header;
+
+    trace_status_t next (char *op, paddr_t *addr);
+    uint64_t bytes_read (void);
+    const trace_header_t *bin_header (void) { return &header; }
+
+private:
+    FILE *infile;
+
+    unsigned char *buf;
+    size_t buf_size;
+    size_t buf_len;
+    size_t pos;
+    uint32_t refs_left;
+    paddr_t prev_addr;
+
+    trace_status_t read_block (void);
+};
+
+/**
+ * Opens path and picks the reader from its first bytes, NULL if missing.
+ * Text traces are mmap'd when use_mmap is set.
+ */
+Trace_reader *open_trace (const char *path, bool use_mmap);
+
+class Bin_trace_writer {
+public:
+    Bin_trace_writer (FILE *outfile, int line_size, int num_cores, int core);
+    ~Bin_trace_writer ();
+
+    /** False, writing nothing, when addr is too far from the previous
+     *  address of the block, see TRACE_BIN_DELTA_LIMIT.  */
+    bool put (char op, paddr_t addr);
+
+    /** Writes out the last partial block.  */
+    void flush (void);
+
+    counter_t bytes_written;
+
+private:
+    FILE *outfile;
+
+    unsigned char *buf;
+    size_t pos;
+    uint32_t num_refs;
+    paddr_t prev_addr;
+};
+
+#endif /*TRACE_H_*/
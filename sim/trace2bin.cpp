@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/**
+ * Converts a trace directory (config plus p%d.trace files) into the binary
+ * format.  The output directory keeps the same file names, so it can be
+ * passed straight to -t.
+ */
+void usage (void)
+{
+    fprintf (stderr, "Usage: trace2bin [-l <cache line size>] <trace directory> <output directory>\n");
+    exit (1);
+}
+
+int main (int argc, char *argv[])
+{
+    char path[512];
+    char out_path[512];
+    int line_size = 64;
+    int num_cores;
+    int c;
+    FILE *config;
+    counter_t text_bytes = 0, bin_bytes = 0;
+
+    while ((c = getopt (argc, argv, "hl:")) != -1)
+    {
+        switch (c) {
+        case 'l':
+            line_size = atoi (optarg);
+            break;
+        default:
+            usage ();
+        }
+    }
+    if (argc - optind != 2)
+        usage ();
+
+    const char *in_dir = argv[optind];
+    const char *out_dir = argv[optind + 1];
+
+    sprintf (path, "%s/config", in_dir);
+    config = fopen (path, "r");
+    if (!config || fscanf (config, "%d", &num_cores) != 1 || num_cores <= 0)
+    {
+        fprintf (stderr, "trace2bin: %s should contain number of traces\n", path);
+        return 1;
+    }
+    fclose (config);
+
+    sprintf (out_path, "%s/config", out_dir);
+    config = fopen (out_path, "w");
+    if (!config)
+    {
+        fprintf (stderr, "trace2bin: unable to create %s\n", out_path);
+        return 1;
+    }
+    fprintf (config, "%d\n", num_cores);
+    fclose (config);
+
+    for (int core = 0; core < num_cores; core++)
+    {
+        FILE *infile, *outfile;
+        char op;
+        paddr_t addr;
+
+        sprintf (path, "%s/p%d.trace", in_dir, core);
+        sprintf (out_path, "%s/p%d.trace", out_dir, core);
+
+        infile = fopen (path, "r");
+        if (!infile)
+        {
+            fprintf (stderr, "trace2bin: unable to open %s\n", path);
+            return 1;
+        }
+        outfile = fopen (out_path, "w");
+        if (!outfile)
+        {
+            fprintf (stderr, "trace2bin: unable to create %s\n", out_path);
+            return 1;
+        }
+
+        Text_trace_reader reader (infile);
+        Bin_trace_writer writer (outfile, line_size, num_cores, core);
+
+        while (reader.next (&op, &addr) == TRACE_OK)
+        {
+            if (op != 'r' && op != 'w')
+            {
+                fprintf (stderr, "trace2bin: %s: unknown operation - %c\n", path, op);
+                return 1;
+            }
+            if (!writer.put (op, addr))
+            {
+                fprintf (stderr, "trace2bin: %s: address 0x%llx is too far from the one "
+                         "before it, deltas must fit in 62 bits\n", path, (unsigned long long)addr);
+                return 1;
+            }
+        }
+        writer.flush ();
+
+        text_bytes += ftell (infile);
+        bin_bytes += writer.bytes_written;
+        fclose (outfile);
+    }
+
+    fprintf (stderr, "trace2bin: %d traces, %llu -> %llu bytes\n", num_cores,
+             (unsigned long long)text_bytes, (unsigned long long)bin_bytes);
+    return 0;
+}
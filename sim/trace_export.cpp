@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mreq.h"
+#include "settings.h"
+#include "sim.h"
+#include "trace_export.h"
+
+extern Sim_settings settings;
+extern Simulator *Sim;
+
+/** Chrome groups tracks by pid, then tid.  */
+#define TE_PID_BUS              0
+#define TE_PID_CORES            1
+#define TE_PID_MEMORY           2
+
+/***************************************************************************
+ * Trace_export constructor, destructor, and functions.
+ ***************************************************************************/
+Trace_export::Trace_export (const char *path, timestamp_t start, timestamp_t end)
+{
+    this->start = start;
+    this->end = end;
+    finished = false;
+    in_progress = false;
+
+    events = (trace_export_event_t *)malloc (TRACE_EXPORT_BUFFER * sizeof (trace_export_event_t));
+    assert (events && "Trace_export: Unable to alloc buffer.");
+    num_events = 0;
+
+    file = fopen (path, "w");
+    if (!file)
+        fatal_error ("Trace_export: Unable to create %s\n", path);
+
+    /** Track names first, then the events.  */
+    fprintf (file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Bus\"}},\n",
+             TE_PID_BUS);
+    fprintf (file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"occupancy\"}},\n",
+             TE_PID_BUS);
+    fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Cores\"}},\n",
+             TE_PID_CORES);
+    for (int i = 0; i < settings.num_nodes; i++)
+        fprintf (file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"core %d\"}},\n",
+                 TE_PID_CORES, i, i);
+    fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Memory\"}},\n",
+             TE_PID_MEMORY);
+    fprintf (file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"controller\"}}",
+             TE_PID_MEMORY);
+}
+
+Trace_export::~Trace_export ()
+{
+    finish ();
+    free (events);
+    fclose (file);
+}
+
+void Trace_export::add (trace_export_kind_t kind, timestamp_t ts, timestamp_t dur,
+                        int node, int peer, int msg, paddr_t addr, uint32_t value)
+{
+    /** Keep what overlaps the window.  */
+    if (ts > end || ts + dur < start)
+        return;
+
+    trace_export_event_t *ev = &events[num_events++];
+    ev->kind = kind;
+    ev->ts = ts;
+    ev->dur = dur;
+    ev->node = node;
+    ev->peer = peer;
+    ev->msg = msg;
+    ev->addr = addr;
+    ev->value = value;
+
+    if (num_events == TRACE_EXPORT_BUFFER)
+        flush ();
+}
+
+void Trace_export::bus_grant (Mreq *request, int queue_depth)
+{
+    int node = request->src_mid.nodeID;
+
+    add (TE_WAIT, request->req_time, Global_Clock - request->req_time, node, -1,
+         request->msg, request->addr, 0);
+    bus_queue (queue_depth);
+
+    /** A writeback is done in one bus cycle, nobody replies.  */
+    if (request->msg == DATA)
+    {
+        add (TE_BUS, Global_Clock, 1, node, request->dest_mid.nodeID, request->msg, request->addr, 0);
+        return;
+    }
+
+    in_progress = true;
+    request_time = request->req_time;
+    grant_time = Global_Clock;
+    requester = node;
+    request_msg = request->msg;
+    request_addr = request->addr;
+}
+
+/** The reply ends both the bus transaction and the requester's miss.  */
+void Trace_export::bus_reply (Mreq *reply)
+{
+    if (!in_progress)
+        return;
+    in_progress = false;
+
+    add (TE_BUS, grant_time, Global_Clock - grant_time + 1, requester, reply->src_mid.nodeID,
+         request_msg, request_addr, 0);
+    add (TE_MISS, request_time, Global_Clock - request_time + 1, requester,
+         reply->src_mid.nodeID, request_msg, request_addr, 0);
+}
+
+void Trace_export::bus_queue (int queue_depth)
+{
+    add (TE_QUEUE, Global_Clock, 0, -1, -1, MREQ_INVALID, 0, queue_depth);
+}
+
+void Trace_export::mc_service (timestamp_t since, paddr_t addr, bool cancelled)
+{
+    add (cancelled ? TE_MC_CANCEL : TE_MC_READ, since, Global_Clock - since,
+         settings.num_nodes, -1, MREQ_INVALID, addr, 0);
+}
+
+/** Who a peer node is, the memory controller lives on node num_nodes.  */
+static void peer_str (int peer, char *buf, size_t size)
+{
+    if (peer == settings.num_nodes)
+        snprintf (buf, size, "memory");
+    else
+        snprintf (buf, size, "core %d", peer);
+}
+
+void Trace_export::write_event (trace_export_event_t *ev)
+{
+    const char *msg = Mreq::message_t_str[ev->msg];
+    char peer[32];
+
+    fprintf (file, ",\n");
+    switch (ev->kind) {
+    case TE_BUS:
+        peer_str (ev->peer, peer, sizeof (peer));
+        fprintf (file, "{\"name\":\"%s\",\"cat\":\"bus\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                 "\"pid\":%d,\"tid\":0,\"args\":{\"addr\":\"0x%llx\",\"core\":%d,\"%s\":\"%s\"}}",
+                 msg, (unsigned long long)ev->ts, (unsigned long long)ev->dur, TE_PID_BUS,
+                 (unsigned long long)ev->addr, ev->node,
+                 ev->msg == DATA ? "data_to" : "data_from", peer);
+        break;
+    case TE_WAIT:
+        fprintf (file, "{\"name\":\"arbitration\",\"cat\":\"bus\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                 "\"pid\":%d,\"tid\":%d,\"args\":{\"msg\":\"%s\",\"addr\":\"0x%llx\"}}",
+                 (unsigned long long)ev->ts, (unsigned long long)ev->dur, TE_PID_CORES, ev->node,
+                 msg, (unsigned long long)ev->addr);
+        break;
+    case TE_MISS:
+        peer_str (ev->peer, peer, sizeof (peer));
+        fprintf (file, "{\"name\":\"%s miss\",\"cat\":\"core\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                 "\"pid\":%d,\"tid\":%d,\"args\":{\"addr\":\"0x%llx\",\"data_from\":\"%s\"}}",
+                 msg, (unsigned long long)ev->ts, (unsigned long long)ev->dur, TE_PID_CORES, ev->node,
+                 (unsigned long long)ev->addr, peer);
+        break;
+    case TE_MC_READ:
+    case TE_MC_CANCEL:
+        fprintf (file, "{\"name\":\"%s\",\"cat\":\"memory\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,"
+                 "\"pid\":%d,\"tid\":0,\"args\":{\"addr\":\"0x%llx\"}}",
+                 ev->kind == TE_MC_READ ? "read" : "cancelled",
+                 (unsigned long long)ev->ts, (unsigned long long)ev->dur, TE_PID_MEMORY,
+                 (unsigned long long)ev->addr);
+        break;
+    case TE_QUEUE:
+        fprintf (file, "{\"name\":\"pending_requests\",\"ph\":\"C\",\"ts\":%llu,\"pid\":%d,"
+                 "\"args\":{\"depth\":%u}}",
+                 (unsigned long long)ev->ts, TE_PID_BUS, ev->value);
+        break;
+    default:
+        fatal_error ("Trace_export: Invalid event kind - %d\n", ev->kind);
+    }
+}
+
+void Trace_export::flush (void)
+{
+    for (int i = 0; i < num_events; i++)
+        write_event (&events[i]);
+    num_events = 0;
+}
+
+void Trace_export::finish (void)
+{
+    if (finished)
+        return;
+    finished = true;
+
+    flush ();
+    fprintf (file, "\n]}\n");
+    fflush (file);
+}
@@ -0,0 +1,76 @@
+#ifndef TRACE_EXPORT_H_
+#define TRACE_EXPORT_H_
+
+#include "types.h"
+
+/** Events held before they are formatted out to the file.  */
+#define TRACE_EXPORT_BUFFER     (1 << 16)
+
+typedef enum {
+    TE_BUS = 0,             /** Bus held by a transaction.  */
+    TE_WAIT,                /** Request waiting in pending_requests.  */
+    TE_MISS,                /** Core's miss from bus request to DATA.  */
+    TE_MC_READ,             /** Memory controller serving a request.  */
+    TE_MC_CANCEL,           /** Ditto, but a cache supplied the data.  */
+    TE_QUEUE                /** pending_requests depth.  */
+} trace_export_kind_t;
+
+typedef struct {
+    timestamp_t ts;
+    timestamp_t dur;
+    paddr_t addr;
+    uint32_t value;
+    int16_t node;
+    int16_t peer;
+    uint8_t kind;
+    uint8_t msg;
+} trace_export_event_t;
+
+/**
+ * Chrome Trace Event JSON of the bus and the memory controller, for
+ * chrome://tracing or ui.perfetto.dev.  One cycle shows as one microsecond.
+ * The bus process has the occupancy track and a pending_requests counter,
+ * each core a track of its misses with the arbitration wait nested inside,
+ * and memory a track of service intervals.  Only events overlapping the
+ * [start, end] cycle window are kept, and events go through a bounded
+ * buffer, so memory stays flat however long the run.
+ */
+class Trace_export {
+public:
+    Trace_export (const char *path, timestamp_t start, timestamp_t end);
+    ~Trace_export ();
+
+    /** Bus side, called from the simulator thread.  */
+    void bus_grant (Mreq *request, int queue_depth);
+    void bus_reply (Mreq *reply);
+    void bus_queue (int queue_depth);
+
+    void mc_service (timestamp_t since, paddr_t addr, bool cancelled);
+
+    /** Flushes and terminates the JSON.  */
+    void finish (void);
+
+private:
+    FILE *file;
+    timestamp_t start;
+    timestamp_t end;
+    bool finished;
+
+    trace_export_event_t *events;
+    int num_events;
+
+    /** The transaction holding the bus, the bus is atomic.  */
+    bool in_progress;
+    timestamp_t request_time;
+    timestamp_t grant_time;
+    int requester;
+    int request_msg;
+    paddr_t request_addr;
+
+    void add (trace_export_kind_t kind, timestamp_t ts, timestamp_t dur,
+              int node, int peer, int msg, paddr_t addr, uint32_t value);
+    void flush (void);
+    void write_event (trace_export_event_t *ev);
+};
+
+#endif /*TRACE_EXPORT_H_*/
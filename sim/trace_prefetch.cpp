@@ -0,0 +1,185 @@
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "trace_prefetch.h"
+
+/***************************************************************************
+ * Trace_ring constructor, destructor, and functions.
+ ***************************************************************************/
+Trace_ring::Trace_ring (int capacity)
+{
+    assert ((capacity & (capacity - 1)) == 0 && "ring size not power of 2?");
+
+    records = new trace_record_t[capacity];
+    mask = capacity - 1;
+    head = 0;
+    tail = 0;
+}
+
+Trace_ring::~Trace_ring ()
+{
+    delete [] records;
+}
+
+bool Trace_ring::push (trace_record_t *rec)
+{
+    uint64_t t = tail;
+
+    if (t - __atomic_load_n (&head, __ATOMIC_ACQUIRE) > mask)
+        return false;
+
+    records[t & mask] = *rec;
+    __atomic_store_n (&tail, t + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool Trace_ring::full (void)
+{
+    return tail - __atomic_load_n (&head, __ATOMIC_ACQUIRE) > mask;
+}
+
+bool Trace_ring::pop (trace_record_t *rec)
+{
+    uint64_t h = head;
+
+    if (h == __atomic_load_n (&tail, __ATOMIC_ACQUIRE))
+        return false;
+
+    *rec = records[h & mask];
+    __atomic_store_n (&head, h + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/***************************************************************************
+ * Prefetch_trace_reader constructor, destructor, and functions.
+ ***************************************************************************/
+Prefetch_trace_reader::Prefetch_trace_reader (Trace_reader *source)
+    : ring (TRACE_PREFETCH_RING)
+{
+    this->source = source;
+    this->file_size = source->file_size;
+    this->source_bytes = 0;
+    this->source_done = false;
+    this->finished = false;
+    this->final_status = TRACE_END;
+}
+
+Prefetch_trace_reader::~Prefetch_trace_reader ()
+{
+    delete source;
+}
+
+trace_status_t Prefetch_trace_reader::next (char *op, paddr_t *addr)
+{
+    trace_record_t rec;
+
+    if (finished)
+        return final_status;
+
+    /** Only waits when the decoder has fallen behind.  */
+    while (!ring.pop (&rec))
+        sched_yield ();
+
+    if (rec.status != TRACE_OK)
+    {
+        finished = true;
+        final_status = rec.status;
+        return final_status;
+    }
+
+    *op = rec.op;
+    *addr = rec.addr;
+    return TRACE_OK;
+}
+
+int Prefetch_trace_reader::fill (int max)
+{
+    trace_record_t rec;
+    int count = 0;
+
+    while (count < max && !source_done && !ring.full ())
+    {
+        rec.status = source->next (&rec.op, &rec.addr);
+        ring.push (&rec);
+        count++;
+        if (rec.status != TRACE_OK)
+            source_done = true;
+    }
+    if (count)
+        __atomic_store_n (&source_bytes, source->bytes_read (), __ATOMIC_RELAXED);
+    return count;
+}
+
+/***************************************************************************
+ * Trace_prefetcher constructor, destructor, and functions.
+ ***************************************************************************/
+Trace_prefetcher::Trace_prefetcher (int num_threads)
+{
+    this->num_threads = num_threads;
+    this->threads = new pthread_t[num_threads];
+    this->args = new decoder_arg_t[num_threads];
+    this->stop = false;
+    readers.clear ();
+}
+
+/** Must run before the processors delete their readers.  */
+Trace_prefetcher::~Trace_prefetcher ()
+{
+    __atomic_store_n (&stop, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < num_threads; i++)
+        pthread_join (threads[i], NULL);
+
+    delete [] threads;
+    delete [] args;
+}
+
+Trace_reader *Trace_prefetcher::attach (Trace_reader *source)
+{
+    Prefetch_trace_reader *reader = new Prefetch_trace_reader (source);
+
+    readers.push_back (reader);
+    return reader;
+}
+
+void Trace_prefetcher::start (void)
+{
+    for (int i = 0; i < num_threads; i++)
+    {
+        args[i].prefetcher = this;
+        args[i].id = i;
+        if (pthread_create (&threads[i], NULL, decoder_main, &args[i]))
+            fatal_error ("Trace_prefetcher: Unable to create decoder %d\n", i);
+    }
+}
+
+void *Trace_prefetcher::decoder_main (void *arg)
+{
+    Trace_prefetcher *prefetcher = ((decoder_arg_t *)arg)->prefetcher;
+    int id = ((decoder_arg_t *)arg)->id;
+
+    while (!__atomic_load_n (&prefetcher->stop, __ATOMIC_ACQUIRE))
+    {
+        int progress = 0;
+        bool all_done = true;
+
+        for (unsigned int i = id; i < prefetcher->readers.size (); i += prefetcher->num_threads)
+        {
+            Prefetch_trace_reader *reader = prefetcher->readers[i];
+
+            if (reader->source_done)
+                continue;
+            all_done = false;
+            progress += reader->fill (TRACE_PREFETCH_BATCH);
+        }
+
+        if (all_done)
+            break;
+        if (!progress)
+            usleep (TRACE_PREFETCH_IDLE_US);
+    }
+    return NULL;
+}
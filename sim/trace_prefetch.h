@@ -0,0 +1,106 @@
+#ifndef TRACE_PREFETCH_H_
+#define TRACE_PREFETCH_H_
+
+#include <pthread.h>
+
+#include "trace.h"
+#include "types.h"
+
+/** Decoded references buffered per processor, power of 2.  */
+#define TRACE_PREFETCH_RING     4096
+
+/** References a decoder pulls from one trace before moving to the next.  */
+#define TRACE_PREFETCH_BATCH    256
+
+/** Decoder nap when every ring it serves is full or finished.  */
+#define TRACE_PREFETCH_IDLE_US  50
+
+typedef struct {
+    paddr_t addr;
+    char op;
+    trace_status_t status;
+} trace_record_t;
+
+/**
+ * Single producer, single consumer ring.  The decoder thread only moves
+ * tail and the simulator only moves head, so neither side takes a lock.
+ */
+class Trace_ring {
+public:
+    Trace_ring (int capacity);
+    ~Trace_ring ();
+
+    bool push (trace_record_t *rec);
+    bool pop (trace_record_t *rec);
+
+    /** Producer side check, so a reference is never decoded and dropped.  */
+    bool full (void);
+
+private:
+    trace_record_t *records;
+    uint64_t mask;
+
+    char pad0[64];
+    uint64_t head;
+    char pad1[64];
+    uint64_t tail;
+    char pad2[64];
+};
+
+/**
+ * Consumer end handed to the Processor in place of the real reader.  The
+ * final record carries the source's END or CORRUPT status, so end_of_trace
+ * is reached exactly where the unbuffered reader would reach it.
+ */
+class Prefetch_trace_reader : public Trace_reader {
+public:
+    Prefetch_trace_reader (Trace_reader *source);
+    ~Prefetch_trace_reader ();
+
+    trace_status_t next (char *op, paddr_t *addr);
+
+    /** As of the decoder's last batch, a ring ahead of the processor.  */
+    uint64_t bytes_read (void) { return __atomic_load_n (&source_bytes, __ATOMIC_RELAXED); }
+
+    /** Decoder side, returns the references buffered.  */
+    int fill (int max);
+    bool source_done;
+
+private:
+    Trace_reader *source;
+    Trace_ring ring;
+    uint64_t source_bytes;
+
+    /** Consumer side copy of the terminating status.  */
+    bool finished;
+    trace_status_t final_status;
+};
+
+/** Background decoder threads, each serving every num_threads'th trace.  */
+class Trace_prefetcher {
+public:
+    Trace_prefetcher (int num_threads);
+    ~Trace_prefetcher ();
+
+    /** Takes ownership of source; the returned reader is the caller's.  */
+    Trace_reader *attach (Trace_reader *source);
+
+    void start (void);
+
+private:
+    int num_threads;
+    pthread_t *threads;
+    bool stop;
+
+    VECTOR<Prefetch_trace_reader*> readers;
+
+    typedef struct {
+        Trace_prefetcher *prefetcher;
+        int id;
+    } decoder_arg_t;
+    decoder_arg_t *args;
+
+    static void *decoder_main (void *arg);
+};
+
+#endif /*TRACE_PREFETCH_H_*/
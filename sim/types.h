@@ -9,6 +9,7 @@
 #include <stack>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <stdint.h>
 #include <cstdio>
 
@@ -18,6 +19,7 @@ using namespace std;
 #define LIST list
 #define SET set
 #define MAP map
+#define HASH_MAP unordered_map
 #define QUEUE queue
 #define STACK stack
 #define VECTOR vector